@@ -301,6 +301,10 @@ For more information, please refer to <http://unlicense.org/>
 #define JET_INPUT 0
 #define JET_OUTPUT 1
 
+/* Bit of header pin gpio in the masks taken by gpioWriteMask */
+
+#define JET_PIN(gpio) ((uint64_t)1 << (gpio))
+
 /* Define the typical interruption trigger */
 
 #define RISING_EDGE 1
@@ -421,7 +425,7 @@ int gpioInitialise(void);
  * @brief Initialises the library.
  * gpioInitialise must be called before using the other library functions, it stores the status of all the relevant registers before using/modifying them.
  * 
- * @return Returns 0 if OK, otherwise a negative number
+ * @return Returns 1 if OK, otherwise a negative number
  *
  * @code if (gpioInitialise() < 0)
  * {
@@ -476,6 +480,18 @@ int gpioWrite(unsigned gpio, unsigned level);
  * @code gpioWrite(24, 1); // Sets pin 24 high. @endcode
 */
 
+int gpioWriteMask(uint64_t pins, uint64_t levels);
+/**<
+ * @brief Sets the level of several GPIOs at once.
+ * Pins that share a controller port change in the same register write, on the Nano that is one write per port instead of one per pin.
+ * Nothing is written if any pin is invalid.
+ * @param pins JET_PIN(gpio) of every pin to write, gpio 3-40
+ * @param levels JET_PIN(gpio) of the pins to set high, the other pins in pins are set low
+ * @return Returns 1 if OK, otherwise a negative number
+ *
+ * @code gpioWriteMask(JET_PIN(35) | JET_PIN(36), JET_PIN(35)); // Sets pin 35 high and pin 36 low. @endcode
+*/
+
 int gpioSetISRFunc(unsigned gpio, unsigned edge, unsigned debounce, unsigned long *timestamp, void (*f)());
 /**<
  * @brief Registers a function to be called (a callback) whenever the specified.
@@ -514,6 +530,41 @@ int gpioPWM(unsigned gpio, unsigned dutycycle);
  *  gpioPWM(33, 128); // Sets pin 33 half on. @endcode
 */
 
+int gpioPWMConfigure(unsigned gpio);
+/**<
+ * @brief Routes the GPIO to its PWM controller once, so gpioPWMDuty can change the duty cycle on its own.
+ * gpioSetPWMfrequency can be called before or after, gpioSetMode undoes it.
+ * @param gpio (15 Orin only), 32, 33
+ * @return Returns 1 if OK, a negative number otherwise
+ *
+ * @code gpioPWMConfigure(32); @endcode
+*/
+
+int gpioPWMDuty(unsigned gpio, unsigned dutycycle);
+/**<
+ * @brief Sets the PWM duty cycle of a GPIO set up with gpioPWMConfigure (or gpioPWM).
+ * Same result as gpioPWM, but on the Nano it is one register write without reading anything back.
+ * @param gpio (15 Orin only), 32, 33
+ * @param dutycycle: 0-256 (0 to 100%)
+ * @return Returns 1 if OK, a negative number otherwise
+ *
+ * @code gpioPWMConfigure(32);
+ *  gpioPWMDuty(32, 128); // Sets pin 32 half on. @endcode
+*/
+
+#ifdef JETGPIO_SIMULATED
+volatile uint32_t *gpioSimulatedRegister(uint32_t address);
+/**<
+ * @brief Only in builds with JETGPIO_SIMULATED (Nano), where gpioInitialise maps the registers to memory instead of /dev/mem.
+ * The registers are in the file named by the JETGPIO_REGISTER_FILE environment variable if it is set, one page per register block
+ * in the order CNF, PINMUX, CFG, PWM, CAR, PMC, otherwise in anonymous memory.
+ * @param address physical address of the register on the Nano
+ * @return Returns a pointer to the simulated register, NULL if it is outside the blocks gpioInitialise mapped
+ *
+ * @code printf("OUT of pin 35 is %x", *gpioSimulatedRegister(base_CNF + CNF_35 + offsetof(GPIO_CNF, OUT))); @endcode
+*/
+#endif
+
 int i2cOpen(unsigned i2cBus, unsigned i2cFlags);
 /**<
  * @brief This returns a handle for the device at the address on the I2C bus.
@@ -182,12 +182,124 @@ static void *status_thread;
 static int thread_n = 0;
 static unsigned pin_tracker = 0;
 
+// Everything gpioSetMode, gpioRead, gpioWrite and gpioPWM need to know about a header pin
+typedef struct {
+  volatile GPIO_CNF *port;      // GPIO port registers, NULL if the header pin is not a GPIO
+  volatile uint32_t *pinmux;
+  volatile uint32_t *pincfg;
+  uint32_t mask;                // Bit of the pin in the port registers
+  uint32_t pinmux_out;          // Pinmux and config values for output, the spi pins need their own
+  uint32_t pincfg_out;
+  unsigned tracker;             // Bit of the pin in pin_tracker
+  unsigned port_index;          // Index of port in port_table
+  volatile uint32_t *pwm;       // PWM controller register, NULL if the pin can't output PWM
+  uint32_t pinmux_pwm;          // Pinmux value that routes the pin to its PWM controller
+  uint32_t pwm_base;            // PWM register without the duty cycle and enable bits, kept up to date once configured
+  unsigned pwm_configured;      // 1 once the pin is routed to its PWM controller (gpioPWMConfigure or gpioPWM)
+} pinDescriptor;
+
+// Indexed by header pin number, filled once by gpioInitialise
+static pinDescriptor pin_table[41];
+
+// Every port a header pin belongs to, gpioWriteMask groups pins by their index in here
+#define MAX_PORTS 32
+static volatile GPIO_CNF *port_table[MAX_PORTS];
+static unsigned port_count = 0;
+
+static void setPinDescriptor(unsigned gpio, volatile GPIO_CNF *port, volatile uint32_t *pinmux, volatile uint32_t *pincfg,
+                             uint32_t mask, uint32_t pinmux_out, uint32_t pincfg_out, unsigned tracker){
+  pin_table[gpio].port = port;
+  pin_table[gpio].pinmux = pinmux;
+  pin_table[gpio].pincfg = pincfg;
+  pin_table[gpio].mask = mask;
+  pin_table[gpio].pinmux_out = pinmux_out;
+  pin_table[gpio].pincfg_out = pincfg_out;
+  pin_table[gpio].tracker = tracker;
+  pin_table[gpio].pwm = NULL;
+  pin_table[gpio].pinmux_pwm = 0;
+  pin_table[gpio].pwm_base = 0;
+  pin_table[gpio].pwm_configured = 0;
+
+  unsigned i = 0;
+  while (i < port_count && port_table[i] != port) {
+    i++;
+  }
+  if (i == port_count) {
+    port_table[port_count++] = port;
+  }
+  pin_table[gpio].port_index = i;
+}
+
+// Descriptor of header pin <gpio>, NULL if it is not a GPIO
+static inline pinDescriptor *getPinDescriptor(unsigned gpio){
+  if (gpio > 40 || pin_table[gpio].port == NULL) {
+    return NULL;
+  }
+  return &pin_table[gpio];
+}
+
+#ifdef JETGPIO_SIMULATED
+// Register blocks of a simulated build, in the order they are laid out in JETGPIO_REGISTER_FILE, one page each
+static const off_t simulated_bases[] = {base_CNF, base_PINMUX, base_CFG, base_PWM, CAR, base_PMC};
+#define SIMULATED_BLOCKS (sizeof(simulated_bases) / sizeof(simulated_bases[0]))
+static void *simulated_blocks[SIMULATED_BLOCKS];
+
+volatile uint32_t *gpioSimulatedRegister(uint32_t address){
+    
+  int pagesize = sysconf(_SC_PAGESIZE);
+  for (unsigned i = 0; i < SIMULATED_BLOCKS; i++) {
+    if (simulated_blocks[i] != NULL && address >= simulated_bases[i] && address < simulated_bases[i] + pagesize) {
+      return (volatile uint32_t *)((char *)simulated_blocks[i] + (address - simulated_bases[i]));
+    }
+  }
+  return NULL;
+}
+#endif
+
+// Maps the page of registers at physical address base, in a simulated build a page of JETGPIO_REGISTER_FILE or of
+// anonymous memory instead
+static void *mapRegisters(off_t base, int pagesize){
+    
+#ifdef JETGPIO_SIMULATED
+  for (unsigned i = 0; i < SIMULATED_BLOCKS; i++) {
+    if (simulated_bases[i] == base) {
+      if (fd_GPIO >= 0) {
+        simulated_blocks[i] = mmap(NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, (off_t)i * pagesize);
+      }
+      else {
+        simulated_blocks[i] = mmap(NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+      }
+      if (simulated_blocks[i] == MAP_FAILED) {
+        simulated_blocks[i] = NULL;
+        return MAP_FAILED;
+      }
+      return simulated_blocks[i];
+    }
+  }
+  return MAP_FAILED;
+#else
+  return mmap(NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base);
+#endif
+}
+
 int gpioInitialise(void){
     
   int status = 1;
   //  Getting the page size
   int pagesize = sysconf(_SC_PAGESIZE);    //getpagesize();
 	
+#ifdef JETGPIO_SIMULATED
+  //  Simulated registers, kept in JETGPIO_REGISTER_FILE if it is set so other processes can look at them
+  const char *register_file = getenv("JETGPIO_REGISTER_FILE");
+  fd_GPIO = -1;
+  if (register_file != NULL) {
+    fd_GPIO = open(register_file, O_RDWR | O_CREAT, 0644);
+    if (fd_GPIO < 0 || ftruncate(fd_GPIO, (off_t)SIMULATED_BLOCKS * pagesize) < 0) {
+      perror(register_file);
+      return -1;
+    }
+  }
+#else
   //  read physical memory (needs root)
   fd_GPIO = open("/dev/mem", O_RDWR | O_SYNC);
   if (fd_GPIO < 0) {
@@ -195,38 +307,39 @@ int gpioInitialise(void){
     fprintf(stderr, "Please run this program as root (for example with sudo)\n");
     return -1;
   }
+#endif
   //  Mapping GPIO_CNF
-  baseCNF = mmap(0, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base_CNF);
+  baseCNF = mapRegisters(base_CNF, pagesize);
   if (baseCNF == MAP_FAILED) {
     return -2;
   }
     
   //  Mapping GPIO_PINMUX
-  basePINMUX = mmap(0, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base_PINMUX);
+  basePINMUX = mapRegisters(base_PINMUX, pagesize);
   if (basePINMUX == MAP_FAILED) {
     return -3;
   }
     
   //  Mapping GPIO_CFG
-  baseCFG = mmap(0, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base_CFG);
+  baseCFG = mapRegisters(base_CFG, pagesize);
   if (baseCFG == MAP_FAILED) {
     return -4;
   }
     
   //  Mapping GPIO_PWM
-  basePWM = mmap(0, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base_PWM);
+  basePWM = mapRegisters(base_PWM, pagesize);
   if (basePWM == MAP_FAILED) {
     return -5;
   }
     
   //  Mapping CAR
-  baseCAR = mmap(0, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, CAR);
+  baseCAR = mapRegisters(CAR, pagesize);
   if (baseCAR == MAP_FAILED) {
     return -6;
   }
 
   //  Mapping PMC
-  basePMC = mmap(NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_GPIO, base_PMC);
+  basePMC = mapRegisters(base_PMC, pagesize);
   if (basePMC == MAP_FAILED) {
     return -7;
   }  
@@ -655,6 +768,41 @@ int gpioInitialise(void){
   pinPWM = (GPIO_PWM volatile *)((char *)basePWM + PM3_PWM0);
   pinPWM_Init = *pinPWM;
 
+  // Pin descriptors, pin register access looks the pin up here instead of switching on its number
+  port_count = 0;
+  setPinDescriptor(3, pin3, pinmux3, pincfg3, 0x00000008, PINMUX_OUT, CFG_OUT, 0);
+  setPinDescriptor(5, pin5, pinmux5, pincfg5, 0x00000004, PINMUX_OUT, CFG_OUT, 1);
+  setPinDescriptor(7, pin7, pinmux7, pincfg7, 0x00000001, PINMUX_OUT, CFG_OUT, 2);
+  setPinDescriptor(8, pin8, pinmux8, pincfg8, 0x00000001, PINMUX_OUT, CFG_OUT, 3);
+  setPinDescriptor(10, pin10, pinmux10, pincfg10, 0x00000002, PINMUX_OUT, CFG_OUT, 4);
+  setPinDescriptor(11, pin11, pinmux11, pincfg11, 0x00000004, PINMUX_OUT, CFG_OUT, 5);
+  setPinDescriptor(12, pin12, pinmux12, pincfg12, 0x00000080, PINMUX_OUT, CFG_OUT, 6);
+  setPinDescriptor(13, pin13, pinmux13, pincfg13, 0x00000040, PINMUX_OUT1, CFG_OUT1, 7);
+  setPinDescriptor(15, pin15, pinmux15, pincfg15, 0x00000004, PINMUX_OUT, CFG_OUT, 8);
+  setPinDescriptor(16, pin16, pinmux16, pincfg16, 0x00000001, PINMUX_OUT1, CFG_OUT1, 9);
+  setPinDescriptor(18, pin18, pinmux18, pincfg18, 0x00000080, PINMUX_OUT1, CFG_OUT1, 10);
+  setPinDescriptor(19, pin19, pinmux19, pincfg19, 0x00000001, PINMUX_OUT1, CFG_OUT1, 11);
+  setPinDescriptor(21, pin21, pinmux21, pincfg21, 0x00000002, PINMUX_OUT1, CFG_OUT1, 12);
+  setPinDescriptor(22, pin22, pinmux22, pincfg22, 0x00000020, PINMUX_OUT1, CFG_OUT1, 13);
+  setPinDescriptor(23, pin23, pinmux23, pincfg23, 0x00000004, PINMUX_OUT1, CFG_OUT1, 14);
+  setPinDescriptor(24, pin24, pinmux24, pincfg24, 0x00000008, PINMUX_OUT1, CFG_OUT1, 15);
+  setPinDescriptor(26, pin26, pinmux26, pincfg26, 0x00000010, PINMUX_OUT1, CFG_OUT1, 16);
+  setPinDescriptor(27, pin27, pinmux27, pincfg27, 0x00000001, PINMUX_OUT, CFG_OUT, 17);
+  setPinDescriptor(28, pin28, pinmux28, pincfg28, 0x00000002, PINMUX_OUT, CFG_OUT, 18);
+  setPinDescriptor(29, pin29, pinmux29, pincfg29, 0x00000020, PINMUX_OUT, CFG_OUT, 19);
+  setPinDescriptor(31, pin31, pinmux31, pincfg31, 0x00000001, PINMUX_OUT, CFG_OUT, 20);
+  setPinDescriptor(32, pin32, pinmux32, pincfg32, 0x00000001, PINMUX_OUT, CFG_OUT, 21);
+  setPinDescriptor(33, pin33, pinmux33, pincfg33, 0x00000040, PINMUX_OUT, CFG_OUT, 22);
+  setPinDescriptor(35, pin35, pinmux35, pincfg35, 0x00000010, PINMUX_OUT, CFG_OUT, 23);
+  setPinDescriptor(36, pin36, pinmux36, pincfg36, 0x00000008, PINMUX_OUT, CFG_OUT, 24);
+  setPinDescriptor(37, pin37, pinmux37, pincfg37, 0x00000010, PINMUX_OUT1, CFG_OUT1, 25);
+  setPinDescriptor(38, pin38, pinmux38, pincfg38, 0x00000020, PINMUX_OUT, CFG_OUT, 26);
+  setPinDescriptor(40, pin40, pinmux40, pincfg40, 0x00000040, PINMUX_OUT, CFG_OUT, 27);
+  pin_table[32].pwm = pinPWM->PWM_0;
+  pin_table[32].pinmux_pwm = 0x00000001;
+  pin_table[33].pwm = pinPWM->PWM_2;
+  pin_table[33].pinmux_pwm = 0x00000002;
+
   // Pointer to APBDEV_PMC_PWR_DET_VAL_0
   apbdev_pmc_pwr_det_val = (uint32_t volatile *)((char *)basePMC + APBDEV_PMC_PWR_DET_VAL_0 + 0x400);
 
@@ -997,423 +1145,52 @@ void gpioTerminate(void){
   // Ummapping PMC registers 
   munmap(basePMC, pagesize);
   
+#ifdef JETGPIO_SIMULATED
+  for (unsigned i = 0; i < SIMULATED_BLOCKS; i++) {
+    simulated_blocks[i] = NULL;
+  }
+  if (fd_GPIO >= 0) {
+    close(fd_GPIO);
+  }
+#else
   // close /dev/mem 
   close(fd_GPIO);
+#endif
 }
 
 int gpioSetMode(unsigned gpio, unsigned mode){
     
   int status = 1;
+  pinDescriptor *pin = getPinDescriptor(gpio);
   if (mode == 0) {
-    switch (gpio){
-		
-    case 3:
-      *pinmux3 = PINMUX_IN;
-      *pincfg3 = CFG_IN;
-      pin3->CNF[0] |= 0x00000008;
-      pin3->OE[0] &= ~(0x00000008);
-      pin_tracker |= 1;
-      break;
-    case 5:
-      *pinmux5 = PINMUX_IN;
-      *pincfg5 = CFG_IN;
-      pin5->CNF[0] |= 0x00000004;
-      pin5->OE[0] &= ~(0x00000004);
-      pin_tracker |= (1 << 1);
-      break;
-    case 7:
-      *pinmux7 = PINMUX_IN;
-      *pincfg7 = CFG_IN;
-      pin7->CNF[0] |= 0x00000001;
-      pin7->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 2);
-      break;
-    case 8:
-      *pinmux8 = PINMUX_IN;
-      *pincfg8 = CFG_IN;
-      pin8->CNF[0] |= 0x00000001;
-      pin8->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 3);
-      break;
-    case 10:
-      *pinmux10 = PINMUX_IN;
-      *pincfg10 = CFG_IN;
-      pin10->CNF[0] |= 0x00000002;
-      pin10->OE[0] &= ~(0x00000002);
-      pin_tracker |= (1 << 4);
-      break;
-    case 11:
-      *pinmux11 = PINMUX_IN;
-      *pincfg11 = CFG_IN;
-      pin11->CNF[0] |= 0x00000004;
-      pin11->OE[0] &= ~(0x00000004);
-      pin_tracker |= (1 << 5);
-      break;
-    case 12:
-      *pinmux12 = PINMUX_IN;
-      *pincfg12 = CFG_IN;
-      pin12->CNF[0] |= 0x00000080;
-      pin12->OE[0] &= ~(0x00000080);
-      pin_tracker |= (1 << 6);
-      break;
-    case 13:
-      *pinmux13 = PINMUX_IN;
-      *pincfg13 = CFG_IN;
-      pin13->CNF[0] |= 0x00000040;
-      pin13->OE[0] &= ~(0x00000040);
-      pin_tracker |= (1 << 7);
-      break;
-    case 15:
-      *pinmux15 = PINMUX_IN;
-      *pincfg15 = CFG_IN;
-      pin15->CNF[0] |= 0x00000004;
-      pin15->OE[0] &= ~(0x00000004);
-      pin_tracker |= (1 << 8);
-      break;
-    case 16:
-      *pinmux16 = PINMUX_IN;
-      *pincfg16 = CFG_IN;
-      pin16->CNF[0] |= 0x00000001;
-      pin16->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 9);
-      break;
-    case 18:
-      *pinmux18 = PINMUX_IN;
-      *pincfg18 = CFG_IN;
-      pin18->CNF[0] |= 0x00000080;
-      pin18->OE[0] &= ~(0x00000080);
-      pin_tracker |= (1 << 10);
-      break;
-    case 19:
-      *pinmux19 = PINMUX_IN;
-      *pincfg19 = CFG_IN;
-      pin19->CNF[0] |= 0x00000001;
-      pin19->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 11);
-      break;
-    case 21:
-      *pinmux21 = PINMUX_IN;
-      *pincfg21 = CFG_IN;
-      pin21->CNF[0] |= 0x00000002;
-      pin21->OE[0] &= ~(0x00000002);
-      pin_tracker |= (1 << 12);
-      break;
-    case 22:
-      *pinmux22 = PINMUX_IN;
-      *pincfg22 = CFG_IN;
-      pin22->CNF[0] |= 0x00000020;
-      pin22->OE[0] &= ~(0x00000020);
-      pin_tracker |= (1 << 13);
-      break;
-    case 23:
-      *pinmux23 = PINMUX_IN;
-      *pincfg23 = CFG_IN;
-      pin23->CNF[0] |= 0x00000004;
-      pin23->OE[0] &= ~(0x00000004);
-      pin_tracker |= (1 << 14);
-      break;
-    case 24:
-      *pinmux24 = PINMUX_IN;
-      *pincfg24 = CFG_IN;
-      pin24->CNF[0] |= 0x00000008;
-      pin24->OE[0] &= ~(0x00000008);
-      pin_tracker |= (1 << 15);
-      break;
-    case 26:
-      *pinmux26 = PINMUX_IN;
-      *pincfg26 = CFG_IN;
-      pin26->CNF[0] |= 0x00000010;
-      pin26->OE[0] &= ~(0x00000010);
-      pin_tracker |= (1 << 16);
-      break;
-    case 27:
-      *pinmux27 = PINMUX_IN;
-      *pincfg27 = CFG_IN;
-      pin27->CNF[0] |= 0x00000001;
-      pin27->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 17);
-      break;
-    case 28:
-      *pinmux28 = PINMUX_IN;
-      *pincfg28 = CFG_IN;
-      pin28->CNF[0] |= 0x00000002;
-      pin28->OE[0] &= ~(0x00000002);
-      pin_tracker |= (1 << 18);
-      break;
-    case 29:
-      *pinmux29 = PINMUX_IN;
-      *pincfg29 = CFG_IN;
-      pin29->CNF[0] |= 0x00000020;
-      pin29->OE[0] &= ~(0x00000020);
-      pin_tracker |= (1 << 19);
-      break;
-    case 31:
-      *pinmux31 = PINMUX_IN;
-      *pincfg31 = CFG_IN;
-      pin31->CNF[0] |= 0x00000001;
-      pin31->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 20);
-      break;
-    case 32:
-      *pinmux32 = PINMUX_IN;
-      *pincfg32 = CFG_IN;
-      pin32->CNF[0] |= 0x00000001;
-      pin32->OE[0] &= ~(0x00000001);
-      pin_tracker |= (1 << 21);
-      break;
-    case 33:
-      *pinmux33 = PINMUX_IN;
-      *pincfg33 = CFG_IN;
-      pin33->CNF[0] |= 0x00000040;
-      pin33->OE[0] &= ~(0x00000040);
-      pin_tracker |= (1 << 22);
-      break;
-    case 35:
-      *pinmux35 = PINMUX_IN;
-      *pincfg35 = CFG_IN;
-      pin35->CNF[0] |= 0x00000010;
-      pin35->OE[0] &= ~(0x00000010);
-      pin_tracker |= (1 << 23);
-      break;
-    case 36:
-      *pinmux36 = PINMUX_IN;
-      *pincfg36 = CFG_IN;
-      pin36->CNF[0] |= 0x00000008;
-      pin36->OE[0] &= ~(0x00000008);
-      pin_tracker |= (1 << 24);
-      break;
-    case 37:
-      *pinmux37 = PINMUX_IN;
-      *pincfg37 = CFG_IN;
-      pin37->CNF[0] |= 0x00000010;
-      pin37->OE[0] &= ~(0x00000010);
-      pin_tracker |= (1 << 25);
-      break;
-    case 38:
-      *pinmux38 = PINMUX_IN;
-      *pincfg38 = CFG_IN;
-      pin38->CNF[0] |= 0x00000020;
-      pin38->OE[0] &= ~(0x00000020);
-      pin_tracker |= (1 << 26);
-      break;
-    case 40:
-      *pinmux40 = PINMUX_IN;
-      *pincfg40 = CFG_IN;
-      pin40->CNF[0] |= 0x00000040;
-      pin40->OE[0] &= ~(0x00000040);
-      pin_tracker |= (1 << 27);
-      break;
-    default:
+    if (pin != NULL) {
+      *pin->pinmux = PINMUX_IN;
+      *pin->pincfg = CFG_IN;
+      pin->pwm_configured = 0;
+      pin->port->CNF[0] |= pin->mask;
+      pin->port->OE[0] &= ~(pin->mask);
+      pin_tracker |= (1 << pin->tracker);
+    }
+    else {
       status = -1;
       printf("Only gpio numbers from 3 to 40 are accepted, this function will read the level on the Jetson Nano header pins,\n");
       printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
     }
   }
   else if (mode == 1) {
-    switch (gpio){
-		
-    case 3:
-      *pinmux3 = PINMUX_OUT;
-      *pincfg3 = CFG_OUT;
-      pin3->CNF[0] |= 0x00000008;
-      pin3->OE[0] |= 0x00000008;
-      pin_tracker |= 1;
-      break;
-    case 5:
-      *pinmux5 = PINMUX_OUT;
-      *pincfg5 = CFG_OUT;
-      pin5->CNF[0] |= 0x00000004;
-      pin5->OE[0] |= 0x00000004;
-      pin_tracker |= (1 << 1);
-      break;
-    case 7:
-      *pinmux7 = PINMUX_OUT;
-      *pincfg7 = CFG_OUT;
-      pin7->CNF[0] |= 0x00000001;
-      pin7->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 2);
-      break;
-    case 8:
-      *pinmux8 = PINMUX_OUT;
-      *pincfg8 = CFG_OUT;
-      pin8->CNF[0] |= 0x00000001;
-      pin8->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 3);
-      break;
-    case 10:
-      *pinmux10 = PINMUX_OUT;
-      *pincfg10 = CFG_OUT;
-      pin10->CNF[0] |= 0x00000002;
-      pin10->OE[0] |= 0x00000002;
-      pin_tracker |= (1 << 4);
-      break;
-    case 11:
-      *pinmux11 = PINMUX_OUT;
-      *pincfg11 = CFG_OUT;
-      pin11->CNF[0] |= 0x00000004;
-      pin11->OE[0] |= 0x00000004;
-      pin_tracker |= (1 << 5);
-      break;
-    case 12:
-      *pinmux12 = PINMUX_OUT;
-      *pincfg12 = CFG_OUT;
-      pin12->CNF[0] |= 0x00000080;
-      pin12->OE[0] |= 0x00000080;
-      pin_tracker |= (1 << 6);
-      break;
-    case 13:
-      *pinmux13 = PINMUX_OUT1;
-      *pincfg13 = CFG_OUT1;
-      pin13->CNF[0] |= 0x00000040;
-      pin13->OE[0] |= 0x00000040;
-      pin_tracker |= (1 << 7);
-      break;
-    case 15:
-      *pinmux15 = PINMUX_OUT;
-      *pincfg15 = CFG_OUT;
-      pin15->CNF[0] |= 0x00000004;
-      pin15->OE[0] |= 0x00000004;
-      pin_tracker |= (1 << 8);
-      break;
-    case 16:
-      *pinmux16 = PINMUX_OUT1;
-      *pincfg16 = CFG_OUT1;
-      pin16->CNF[0] |= 0x00000001;
-      pin16->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 9);
-      break;
-    case 18:
-      *pinmux18 = PINMUX_OUT1;
-      *pincfg18 = CFG_OUT1;
-      pin18->CNF[0] |= 0x00000080;
-      pin18->OE[0] |= 0x00000080;
-      pin_tracker |= (1 << 10);
-      break;
-    case 19:
-      *pinmux19 = PINMUX_OUT1;
-      *pincfg19 = CFG_OUT1;
-      pin19->CNF[0] |= 0x00000001;
-      pin19->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 11);
-      break;
-    case 21:
-      *pinmux21 = PINMUX_OUT1;
-      *pincfg21 = CFG_OUT1;
-      pin21->CNF[0] |= 0x00000002;
-      pin21->OE[0] |= 0x00000002;
-      pin_tracker |= (1 << 12);
-      break;
-    case 22:
-      *pinmux22 = PINMUX_OUT1;
-      *pincfg22 = CFG_OUT1;
-      pin22->CNF[0] |= 0x00000020;
-      pin22->OE[0] |= 0x00000020;
-      pin_tracker |= (1 << 13);
-      break;
-    case 23:
-      *pinmux23 = PINMUX_OUT1;
-      *pincfg23 = CFG_OUT1;
-      pin23->CNF[0] |= 0x00000004;
-      pin23->OE[0] |= 0x00000004;
-      pin_tracker |= (1 << 14);
-      break;
-    case 24:
-      *pinmux24 = PINMUX_OUT1;
-      *pincfg24 = CFG_OUT1;
-      pin24->CNF[0] |= 0x00000008;
-      pin24->OE[0] |= 0x00000008;
-      pin_tracker |= (1 << 15);
-      break;
-    case 26:
-      *pinmux26 = PINMUX_OUT1;
-      *pincfg26 = CFG_OUT1;
-      pin26->CNF[0] |= 0x00000010;
-      pin26->OE[0] |= 0x00000010;
-      pin_tracker |= (1 << 16);
-      break;
-    case 27:
-      *pinmux27 = PINMUX_OUT;
-      *pincfg27 = CFG_OUT;
-      pin27->CNF[0] |= 0x00000001;
-      pin27->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 17);
-      break;
-    case 28:
-      *pinmux28 = PINMUX_OUT;
-      *pincfg28 = CFG_OUT;
-      pin28->CNF[0] |= 0x00000002;
-      pin28->OE[0] |= 0x00000002;
-      pin_tracker |= (1 << 18);
-      break;
-    case 29:
-      *pinmux29 = PINMUX_OUT;
-      *pincfg29 = CFG_OUT;
-      pin29->CNF[0] |= 0x00000020;
-      pin29->OE[0] |= 0x00000020;
-      pin_tracker |= (1 << 19);
-      break;
-    case 31:
-      *pinmux31 = PINMUX_OUT;
-      *pincfg31 = CFG_OUT;
-      pin31->CNF[0] |= 0x00000001;
-      pin31->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 20);
-      break;
-    case 32:
-      *pinmux32 = PINMUX_OUT;
-      *pincfg32 = CFG_OUT;
-      pin32->CNF[0] |= 0x00000001;
-      pin32->OE[0] |= 0x00000001;
-      pin_tracker |= (1 << 21);
-      break;
-    case 33:
-      *pinmux33 = PINMUX_OUT;
-      *pincfg33 = CFG_OUT;
-      pin33->CNF[0] |= 0x00000040;
-      pin33->OE[0] |= 0x00000040;
-      pin_tracker |= (1 << 22);
-      break;
-    case 35:
-      *pinmux35 = PINMUX_OUT;
-      *pincfg35 = CFG_OUT;
-      pin35->CNF[0] |= 0x00000010;
-      pin35->OE[0] |= 0x00000010;
-      pin_tracker |= (1 << 23);
-      break;
-    case 36:
-      *pinmux36 = PINMUX_OUT;
-      *pincfg36 = CFG_OUT;
-      pin36->CNF[0] |= 0x00000008;
-      pin36->OE[0] |= 0x00000008;
-      pin_tracker |= (1 << 24);
-      break;
-    case 37:
-      *pinmux37 = PINMUX_OUT1;
-      *pincfg37 = CFG_OUT1;
-      pin37->CNF[0] |= 0x00000010;
-      pin37->OE[0] |= 0x00000010;
-      pin_tracker |= (1 << 25);
-      break;
-    case 38:
-      *pinmux38 = PINMUX_OUT;
-      *pincfg38 = CFG_OUT;
-      pin38->CNF[0] |= 0x00000020;
-      pin38->OE[0] |= 0x00000020;
-      pin_tracker |= (1 << 26);
-      break;
-    case 40:
-      *pinmux40 = PINMUX_OUT;
-      *pincfg40 = CFG_OUT;
-      pin40->CNF[0] |= 0x00000040;
-      pin40->OE[0] |= 0x00000040;
-      pin_tracker |= (1 << 27);
-      break;
-    default:
+    if (pin != NULL) {
+      *pin->pinmux = pin->pinmux_out;
+      *pin->pincfg = pin->pincfg_out;
+      pin->pwm_configured = 0;
+      pin->port->CNF[0] |= pin->mask;
+      pin->port->OE[0] |= pin->mask;
+      pin_tracker |= (1 << pin->tracker);
+    }
+    else {
       status = -2;
       printf("Only gpio numbers from 3 to 40 are accepted, this function will only write the level on the Jetson Nano header pins,\n");
       printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
     }
-		
   }
   else {printf("Only modes allowed are JET_INPUT and JET_OUTPUT\n");
     status = -3;
@@ -1423,294 +1200,73 @@ int gpioSetMode(unsigned gpio, unsigned mode){
 
 int gpioRead(unsigned gpio){
     
-  int level = 0;
-  switch (gpio){
-		
-  case 3:
-    level = (pin3->IN[0])>>3 & 1;
-    break;
-  case 5:
-    level = (pin5->IN[0])>>2 & 1;
-    break;
-  case 7:
-    level = pin7->IN[0] & 1;
-    break;
-  case 8:
-    level = pin8->IN[0] & 1;
-    break;
-  case 10:
-    level = (pin10->IN[0])>>1 & 1;
-    break;
-  case 11:
-    level = (pin11->IN[0])>>2 & 1;
-    break;
-  case 12:
-    level = (pin12->IN[0])>>7 & 1;
-    break;
-  case 13:
-    level = (pin13->IN[0])>>6 & 1;
-    break;
-  case 15:
-    level = (pin15->IN[0])>>2 & 1;
-    break;
-  case 16:
-    level = pin16->IN[0] & 1;
-    break;
-  case 18:
-    level = (pin18->IN[0])>>7 & 1;
-    break;
-  case 19:
-    level = pin19->IN[0] & 1;
-    break;
-  case 21:
-    level = (pin21->IN[0])>>1 & 1;
-    break;
-  case 22:
-    level = (pin22->IN[0])>>5 & 1;
-    break;
-  case 23:
-    level = (pin23->IN[0])>>2 & 1;
-    break;
-  case 24:
-    level = (pin24->IN[0])>>3 & 1;
-    break;
-  case 26:
-    level = (pin26->IN[0])>>4 & 1;
-    break;
-  case 27:
-    level = pin27->IN[0] & 1;
-    break;
-  case 28:
-    level = (pin28->IN[0])>>1 & 1;
-    break;
-  case 29:
-    level = (pin29->IN[0])>>5 & 1;
-    break;
-  case 31:
-    level = pin31->IN[0] & 1;
-    break;
-  case 32:
-    level = pin32->IN[0] & 1;
-    break;
-  case 33:
-    level = (pin33->IN[0])>>6 & 1;
-    break;
-  case 35:
-    level = (pin35->IN[0])>>4 & 1;
-    break;
-  case 36:
-    level = (pin36->IN[0])>>3 & 1;
-    break;
-  case 37:
-    level = (pin37->IN[0])>>4 & 1;
-    break;
-  case 38:
-    level = (pin38->IN[0])>>5 & 1;
-    break;
-  case 40:
-    level = (pin40->IN[0])>>6 & 1;
-    break;
-  default:
-    level = -1;
+  pinDescriptor *pin = getPinDescriptor(gpio);
+  if (pin == NULL) {
     printf("Only gpio numbers from 3 to 40 are accepted, this function will only read the level of the Jetson Nano header pins,\n");
     printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
+    return -1;
   }
-  return level;
+  return (pin->port->IN[0] & pin->mask) != 0;
 }
 
 int gpioWrite(unsigned gpio, unsigned level){
     
-  int status = 1;
+  pinDescriptor *pin = getPinDescriptor(gpio);
+  if (level > 1) {
+    printf("Only levels 0 or 1 are allowed\n");
+    return -3;
+  }
+  if (pin == NULL) {
+    printf("Only gpio numbers from 3 to 40 are accepted, this function will only read the level of the Jetson Nano header pins,\n");
+    printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
+    return level == 0 ? -1 : -2;
+  }
   if (level == 0) {
-    switch (gpio){
-		
-    case 3:
-      pin3->OUT[0] &= ~(0x00000008);
-      break;
-    case 5:
-      pin5->OUT[0] &= ~(0x00000004);
-      break;
-    case 7:
-      pin7->OUT[0] &= ~(0x00000001);
-      break;
-    case 8:
-      pin8->OUT[0] &= ~(0x00000001);
-      break;
-    case 10:
-      pin10->OUT[0] &= ~(0x00000002);
-      break;
-    case 11:
-      pin11->OUT[0] &= ~(0x00000004);
-      break;
-    case 12:
-      pin12->OUT[0] &= ~(0x00000080);
-      break;
-    case 13:
-      pin13->OUT[0] &= ~(0x00000040);
-      break;
-    case 15:
-      pin15->OUT[0] &= ~(0x00000004);
-      break;
-    case 16:
-      pin16->OUT[0] &= ~(0x00000001);
-      break;
-    case 18:
-      pin18->OUT[0] &= ~(0x00000080);
-      break;
-    case 19:
-      pin19->OUT[0] &= ~(0x00000001);
-      break;
-    case 21:
-      pin21->OUT[0] &= ~(0x00000002);
-      break;
-    case 22:
-      pin22->OUT[0] &= ~(0x00000020);
-      break;
-    case 23:
-      pin23->OUT[0] &= ~(0x00000004);
-      break;
-    case 24:
-      pin24->OUT[0] &= ~(0x00000008);
-      break;
-    case 26:
-      pin26->OUT[0] &= ~(0x00000010);
-      break;
-    case 27:
-      pin27->OUT[0] &= ~(0x00000001);
-      break;
-    case 28:
-      pin28->OUT[0] &= ~(0x00000002);
-      break;
-    case 29:
-      pin29->OUT[0] &= ~(0x00000020);
-      break;
-    case 31:
-      pin31->OUT[0] &= ~(0x00000001);
-      break;
-    case 32:
-      pin32->OUT[0] &= ~(0x00000001);
-      break;
-    case 33:
-      pin33->OUT[0] &= ~(0x00000040);
-      break;
-    case 35:
-      pin35->OUT[0] &= ~(0x00000010);
-      break;
-    case 36:
-      pin36->OUT[0] &= ~(0x00000008);
-      break;
-    case 37:
-      pin37->OUT[0] &= ~(0x00000010);
-      break;
-    case 38:
-      pin38->OUT[0] &= ~(0x00000020);
-      break;
-    case 40:
-      pin40->OUT[0] &= ~(0x00000040);
-      break;
-    default:
-      status = -1;
-      printf("Only gpio numbers from 3 to 40 are accepted, this function will only read the level of the Jetson Nano header pins,\n");
-      printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
-    }
+    pin->port->OUT[0] &= ~(pin->mask);
   }
-  else if (level == 1) {
-    switch (gpio){
-		
-    case 3:
-      pin3->OUT[0] |= level<<3;
-      break;
-    case 5:
-      pin5->OUT[0] |= level<<2;
-      break;
-    case 7:
-      pin7->OUT[0] |= level;
-      break;
-    case 8:
-      pin8->OUT[0] |= level;
-      break;
-    case 10:
-      pin10->OUT[0] |= level<<1;
-      break;
-    case 11:
-      pin11->OUT[0] |= level<<2;
-      break;
-    case 12:
-      pin12->OUT[0] |= level<<7;
-      break;
-    case 13:
-      pin13->OUT[0] |= level<<6;
-      break;
-    case 15:
-      pin15->OUT[0] |= level<<2;
-      break;
-    case 16:
-      pin16->OUT[0] |= level;
-      break;
-    case 18:
-      pin18->OUT[0] |= level<<7;
-      break;
-    case 19:
-      pin19->OUT[0] |= level;
-      break;
-    case 21:
-      pin21->OUT[0] |= level<<1;
-      break;
-    case 22:
-      pin22->OUT[0] |= level<<5;
-      break;
-    case 23:
-      pin23->OUT[0] |= level<<2;
-      break;
-    case 24:
-      pin24->OUT[0] |= level<<3;
-      break;
-    case 26:
-      pin26->OUT[0] |= level<<4;
-      break;
-    case 27:
-      pin27->OUT[0] |= level;
-      break;
-    case 28:
-      pin28->OUT[0] |= level<<1;
-      break;
-    case 29:
-      pin29->OUT[0] |= level<<5;
-      break;
-    case 31:
-      pin31->OUT[0] |= level;
-      break;
-    case 32:
-      pin32->OUT[0] |= level;
-      break;
-    case 33:
-      pin33->OUT[0] |= level<<6;
-      break;
-    case 35:
-      pin35->OUT[0] |= level<<4;
-      break;
-    case 36:
-      pin36->OUT[0] |= level<<3;
-      break;
-    case 37:
-      pin37->OUT[0] |= level<<4;
-      break;
-    case 38:
-      pin38->OUT[0] |= level<<5;
-      break;
-    case 40:
-      pin40->OUT[0] |= level<<6;
-      break;
-    default:
-      status = -2;
-      printf("Only gpio numbers from 3 to 40 are accepted, this function will only read the level of the Jetson Nano header pins,\n");
+  else {
+    pin->port->OUT[0] |= pin->mask;
+  }
+  return 1;
+}
+
+int gpioWriteMask(uint64_t pins, uint64_t levels){
+    
+  // Bits to set and clear in each port, a port is only written if its bit is in used
+  uint32_t set[MAX_PORTS];
+  uint32_t clear[MAX_PORTS];
+  uint32_t used = 0;
+
+  // Check every pin before touching any register so a bad pin writes nothing
+  for (uint64_t remaining = pins; remaining != 0; remaining &= remaining - 1) {
+    unsigned gpio = __builtin_ctzll(remaining);
+    pinDescriptor *pin = getPinDescriptor(gpio);
+    if (pin == NULL) {
+      printf("Only gpio numbers from 3 to 40 are accepted, this function will only write the level of the Jetson Nano header pins,\n");
       printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
+      return -1;
+    }
+
+    unsigned i = pin->port_index;
+    if (!((used >> i) & 1)) {
+      set[i] = 0;
+      clear[i] = 0;
+      used |= 1u << i;
+    }
+    if ((levels >> gpio) & 1) {
+      set[i] |= pin->mask;
+    }
+    else {
+      clear[i] |= pin->mask;
     }
   }
-  else {printf("Only levels 0 or 1 are allowed\n");
-    status = -3;
+
+  // One read-modify-write per port, the pins of a port change together
+  for (; used != 0; used &= used - 1) {
+    unsigned i = __builtin_ctz(used);
+    port_table[i]->OUT[0] = (port_table[i]->OUT[0] & ~clear[i]) | set[i];
   }
-  return status;
+  return 1;
 }
 
 void *callback(void *arg){
@@ -2025,16 +1581,13 @@ int gpioSetPWMfrequency(unsigned gpio, unsigned frequency){
   int PFM = 0;
   if ((frequency >= 25) && (frequency <=187000)){
     PFM = round(187500.0/(double)frequency)-1;
-    switch (gpio){
-    case 32:
-      pinPWM->PWM_0[0] = 0x0;
-      pinPWM->PWM_0[0] = PFM;
-      break;
-    case 33:
-      pinPWM->PWM_2[0] = 0x0;
-      pinPWM->PWM_2[0] = PFM;
-      break;
-    default:
+    pinDescriptor *pin = getPinDescriptor(gpio);
+    if (pin != NULL && pin->pwm != NULL) {
+      pin->pwm[0] = 0x0;
+      pin->pwm[0] = PFM;
+      pin->pwm_base = PFM;
+    }
+    else {
       status = -1;
       printf("Only gpio numbers 32 and 33 are accepted\n");
     }
@@ -2049,25 +1602,18 @@ int gpioPWM(unsigned gpio, unsigned dutycycle){
     
   int status = 1;
   if ((dutycycle >= 0) && (dutycycle <=256)){
-    switch (gpio){
-		
-    case 32:
-      *pinmux32 = 0x00000001;
-      *pincfg32 = CFG_OUT;
-      pin32->CNF[0] &= ~(0x00000001);
-      pinPWM->PWM_0[0] &= ~(0xFFFF0000);
-      pinPWM->PWM_0[0] |= dutycycle<<16;
-      pinPWM->PWM_0[0] |= 0x80000000;
-      break;
-    case 33:
-      *pinmux33 = 0x00000002;
-      *pincfg33 = CFG_OUT;
-      pin33->CNF[0] &= ~(0x00000040);
-      pinPWM->PWM_2[0] &= ~(0xFFFF0000);
-      pinPWM->PWM_2[0] |= dutycycle<<16;
-      pinPWM->PWM_2[0] |= 0x80000000;
-      break;
-    default:
+    pinDescriptor *pin = getPinDescriptor(gpio);
+    if (pin != NULL && pin->pwm != NULL) {
+      *pin->pinmux = pin->pinmux_pwm;
+      *pin->pincfg = CFG_OUT;
+      pin->port->CNF[0] &= ~(pin->mask);
+      pin->pwm[0] &= ~(0xFFFF0000);
+      pin->pwm[0] |= dutycycle<<16;
+      pin->pwm[0] |= 0x80000000;
+      pin->pwm_base = pin->pwm[0] & 0x0000FFFF;
+      pin->pwm_configured = 1;
+    }
+    else {
       status = -1;
       printf("Only gpio numbers 32 and 33 are accepted,\n");
     }
@@ -2078,6 +1624,36 @@ int gpioPWM(unsigned gpio, unsigned dutycycle){
   return status;
 }
 
+int gpioPWMConfigure(unsigned gpio){
+    
+  pinDescriptor *pin = getPinDescriptor(gpio);
+  if (pin == NULL || pin->pwm == NULL) {
+    printf("Only gpio numbers 32 and 33 are accepted,\n");
+    return -1;
+  }
+  *pin->pinmux = pin->pinmux_pwm;
+  *pin->pincfg = CFG_OUT;
+  pin->port->CNF[0] &= ~(pin->mask);
+  pin->pwm_base = pin->pwm[0] & 0x0000FFFF;
+  pin->pwm_configured = 1;
+  return 1;
+}
+
+int gpioPWMDuty(unsigned gpio, unsigned dutycycle){
+    
+  pinDescriptor *pin = getPinDescriptor(gpio);
+  if (dutycycle > 256) {
+    printf("Only a dutycycle from 0 to 256 is allowed\n");
+    return -2;
+  }
+  if (pin == NULL || !pin->pwm_configured) {
+    printf("Only gpio numbers 32 and 33 set up with gpioPWMConfigure are accepted\n");
+    return -1;
+  }
+  pin->pwm[0] = 0x80000000 | dutycycle<<16 | pin->pwm_base;
+  return 1;
+}
+
 int i2c_smbus_access(int file, char read_write, __u8 command, int size, union i2c_smbus_data *data){
     
   struct i2c_smbus_ioctl_data args;
@@ -1798,6 +1798,29 @@ int gpioWrite(unsigned gpio, unsigned level) {
   return status;
 }
 
+int gpioWriteMask(uint64_t pins, uint64_t levels) {
+  // Header pins gpioWrite accepts, checked before any write so a bad pin writes nothing
+  const uint64_t header_pins = JET_PIN(3) | JET_PIN(5) | JET_PIN(7) | JET_PIN(8) | JET_PIN(10) | JET_PIN(11) | JET_PIN(12) |
+    JET_PIN(13) | JET_PIN(15) | JET_PIN(16) | JET_PIN(18) | JET_PIN(19) | JET_PIN(21) | JET_PIN(22) | JET_PIN(23) |
+    JET_PIN(24) | JET_PIN(26) | JET_PIN(27) | JET_PIN(28) | JET_PIN(29) | JET_PIN(31) | JET_PIN(32) | JET_PIN(33) |
+    JET_PIN(35) | JET_PIN(36) | JET_PIN(37) | JET_PIN(38) | JET_PIN(40);
+  if (pins & ~header_pins) {
+    printf("Only gpio numbers from 3 to 40 are accepted, this function will only write the level of the Jetson header pins,\n");
+    printf("numbered as the header pin numbers e.g. AUD_MCLK is pin header number 7\n");
+    return -1;
+  }
+
+  // Every Orin pin has an output register of its own, so the pins are written one at a time
+  for (uint64_t remaining = pins; remaining != 0; remaining &= remaining - 1) {
+    unsigned gpio = __builtin_ctzll(remaining);
+    int status = gpioWrite(gpio, (levels >> gpio) & 1);
+    if (status < 0) {
+      return status;
+    }
+  }
+  return 1;
+}
+
 void *callback(void *arg) {
   ISRFunc *int_struct = (ISRFunc *) arg;
   unsigned gpio = int_struct->gpio;
@@ -2138,6 +2161,19 @@ int gpioPWM(unsigned gpio, unsigned dutycycle) {
   return status;
 }
 
+int gpioPWMConfigure(unsigned gpio) {
+  // Orin's PWM pins need no routing, so there is nothing to set up
+  if (gpio != 15 && gpio != 32 && gpio != 33) {
+    printf("Only gpio numbers 15, 32 and 33 are accepted,\n");
+    return -1;
+  }
+  return 1;
+}
+
+int gpioPWMDuty(unsigned gpio, unsigned dutycycle) {
+  return gpioPWM(gpio, dutycycle);
+}
+
 int i2c_smbus_access(int file, char read_write, __u8 command, int size, union i2c_smbus_data *data) {
   struct i2c_smbus_ioctl_data args;
   args.read_write = read_write;
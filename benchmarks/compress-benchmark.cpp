@@ -0,0 +1,139 @@
+// Compression ratio and speed of the two ENet compressors (range coder and LZ) on telemetry datagrams
+// There is no telemetry recording in the repo, so frames are generated like the robot's status stream: a binary
+// frame with a counter, timestamp, slowly drifting motor currents and temperatures and mostly constant status bits,
+// sometimes followed by a text status message. ENet packs several frames into one datagram when they queue up,
+// so each size is measured with 1, 4 and 16 frames per datagram, each frame behind its ENet command header
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, CMAKE_BUILD_TYPE=Release) and run: ./compress-benchmark [datagrams]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <enet/enet.h>
+
+#define COMMAND_HEADER_SIZE 8 // Send unsequenced command header in front of each frame
+#define MOTION_CHANNEL_ID 0
+
+struct Compressor
+{
+    const char *name;
+    void *(*create)(void);
+    void (*destroy)(void *);
+    size_t (*compress)(void *, const ENetBuffer *, size_t, size_t, enet_uint8 *, size_t);
+    size_t (*decompress)(void *, const enet_uint8 *, size_t, enet_uint8 *, size_t);
+};
+
+// One telemetry frame, little endian fields like the robot would send them
+static std::vector<uint8_t> telemetryFrame(uint32_t index)
+{
+    std::vector<uint8_t> frame;
+    auto put = [&frame](uint32_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            frame.push_back((uint8_t)(value >> (8 * i)));
+    };
+
+    put(0xA55A, 2);        // Frame type
+    put(index, 4);         // Counter
+    put(index * 20, 4);    // Timestamp in ms
+    for (int motor = 0; motor < 4; motor++)
+    {
+        put((uint32_t)(1200 + 300 * std::sin(index * 0.01 + motor) + (index * 7 + motor) % 5), 2); // Current in mA
+        put((uint32_t)(350 + motor + index / 500), 2);                                             // Temperature in 0.1 C
+        put((uint32_t)(index % 200 < 100 ? 60 : -60), 1);                                           // Drive percent
+    }
+    put(12400 - index / 100, 2); // Battery in mV
+    put(0x0003, 2);              // Status bits
+    put(0, 4);                   // Reserved
+
+    if (index % 8 == 0)
+    {
+        char status[64];
+        int length = std::snprintf(status, sizeof(status), "Actuator 1: extending, Actuator 2: idle, ticks %u", index);
+        frame.insert(frame.end(), status, status + length);
+    }
+    return frame;
+}
+
+int main(int argc, char **argv)
+{
+    const long datagrams = argc > 1 ? std::atol(argv[1]) : 50000;
+    const int framesPerDatagram[] = {1, 4, 16};
+    const Compressor compressors[] = {
+        {"range coder", enet_range_coder_create, enet_range_coder_destroy, enet_range_coder_compress, enet_range_coder_decompress},
+        {"lz", enet_lz_create, enet_lz_destroy, enet_lz_compress, enet_lz_decompress},
+    };
+
+    enet_initialize();
+    std::cout << "Frames  Compressor   Ratio  Compress MB/s  Decompress MB/s\n";
+    for (int frames : framesPerDatagram)
+    {
+        // Pre-build the datagrams as buffer lists, the way ENet hands them to the compressor
+        std::vector<std::vector<uint8_t>> chunks;
+        uint8_t headers[16][COMMAND_HEADER_SIZE];
+        for (long i = 0; i < (long)(frames * 64); i++)
+            chunks.push_back(telemetryFrame((uint32_t)i));
+
+        for (const Compressor &compressor : compressors)
+        {
+            void *context = compressor.create();
+            uint8_t compressed[ENET_PROTOCOL_MAXIMUM_MTU], decompressed[ENET_PROTOCOL_MAXIMUM_MTU], original[ENET_PROTOCOL_MAXIMUM_MTU];
+            long inBytes = 0, outBytes = 0, failures = 0;
+            int64_t compressNs = 0, decompressNs = 0;
+
+            for (long d = 0; d < datagrams; d++)
+            {
+                ENetBuffer buffers[2 * 16];
+                size_t bufferCount = 0, length = 0;
+                for (int f = 0; f < frames; f++)
+                {
+                    std::vector<uint8_t> &frame = chunks[(d * frames + f) % chunks.size()];
+                    uint8_t *header = headers[f];
+                    const uint32_t sequence = (uint32_t)(d * frames + f);
+                    const uint8_t command[COMMAND_HEADER_SIZE] = {0x49, MOTION_CHANNEL_ID, (uint8_t)(sequence >> 8), (uint8_t)sequence,
+                                                                  (uint8_t)(sequence >> 8), (uint8_t)sequence, 0x00, (uint8_t)frame.size()};
+                    std::memcpy(header, command, sizeof(command));
+                    buffers[bufferCount].data = header;
+                    buffers[bufferCount++].dataLength = COMMAND_HEADER_SIZE;
+                    buffers[bufferCount].data = frame.data();
+                    buffers[bufferCount++].dataLength = frame.size();
+                    std::memcpy(original + length, header, COMMAND_HEADER_SIZE);
+                    std::memcpy(original + length + COMMAND_HEADER_SIZE, frame.data(), frame.size());
+                    length += COMMAND_HEADER_SIZE + frame.size();
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                size_t compressedLength = compressor.compress(context, buffers, bufferCount, length, compressed, length);
+                auto middle = std::chrono::steady_clock::now();
+                compressNs += std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count();
+
+                inBytes += length;
+                if (compressedLength == 0)
+                {
+                    outBytes += length; // ENet sends it uncompressed
+                    continue;
+                }
+                outBytes += compressedLength;
+
+                middle = std::chrono::steady_clock::now();
+                size_t decompressedLength = compressor.decompress(context, compressed, compressedLength, decompressed, sizeof(decompressed));
+                decompressNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - middle).count();
+                if (decompressedLength != length || std::memcmp(decompressed, original, length) != 0)
+                    failures++;
+            }
+
+            std::printf("%-7d %-12s %5.2f  %13.1f  %15.1f%s\n", frames, compressor.name, (double)inBytes / outBytes,
+                        inBytes * 1000.0 / compressNs, inBytes * 1000.0 / decompressNs, failures > 0 ? "  (ROUND TRIP FAILED)" : "");
+            compressor.destroy(context);
+        }
+    }
+
+    enet_deinitialize();
+    return 0;
+}
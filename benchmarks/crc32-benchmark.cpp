@@ -0,0 +1,79 @@
+// Throughput of enet_crc32 (ENetHost::checksum) by datagram size, against the byte at a time table CRC ENet
+// shipped with. enet_initialize picks slice-by-8, or the ARMv8 CRC32 instructions when the CPU has them
+// Both are called through an ENetChecksumCallback pointer like ENet does
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, ENet is optimized like the table copy here unless a Debug
+//  build type is picked) and run: ./crc32-benchmark [bytes per size]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <enet/enet.h>
+
+static uint32_t byteTable[256];
+
+// The original byte at a time enet_crc32
+static enet_uint32 ENET_CALLBACK byteCrc32(const ENetBuffer *buffers, size_t bufferCount)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (; bufferCount > 0; bufferCount--, buffers++)
+    {
+        const uint8_t *data = (const uint8_t *)buffers->data;
+        for (std::size_t i = 0; i < buffers->dataLength; i++)
+            crc = (crc >> 8) ^ byteTable[(crc & 0xFF) ^ data[i]];
+    }
+    return ENET_HOST_TO_NET_32(~crc);
+}
+
+static double megabytesPerSecond(const std::vector<uint8_t> &data, std::size_t size, long bytes, ENetChecksumCallback volatile crc, uint32_t &result)
+{
+    const long calls = bytes / size;
+    uint32_t sum = 0;
+    ENetBuffer buffer;
+    buffer.dataLength = size;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < calls; i++)
+    {
+        buffer.data = (void *)&data[(i * 61) % (data.size() - size)]; // Move around so the CRC can't be hoisted
+        sum += crc(&buffer, 1);
+    }
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    result = sum;
+    return (double)calls * size * 1000 / nanos;
+}
+
+int main(int argc, char **argv)
+{
+    const long bytes = argc > 1 ? std::atol(argv[1]) : 256L * 1024 * 1024;
+    const std::size_t sizes[] = {4, 8, 16, 32, 64, 256, 1024, 1400};
+
+    enet_initialize();
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        byteTable[i] = crc;
+    }
+
+    std::vector<uint8_t> data(64 * 1024);
+    for (std::size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 2654435761u >> 13);
+
+    std::cout << "enet_crc32 implementation: " << enet_crc32_implementation() << "\n";
+    std::cout << "Size\tTable MB/s\tenet_crc32 MB/s\tSpeedup\n";
+    for (std::size_t size : sizes)
+    {
+        uint32_t tableSum, enetSum;
+        double table = megabytesPerSecond(data, size, bytes, byteCrc32, tableSum);
+        double fast = megabytesPerSecond(data, size, bytes, enet_crc32, enetSum);
+        std::cout << size << "\t" << table << "\t\t" << fast << "\t\t" << fast / table << "x"
+                  << (tableSum == enetSum ? "" : "  (MISMATCH)") << "\n";
+    }
+
+    enet_deinitialize();
+    return 0;
+}
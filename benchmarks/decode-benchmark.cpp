@@ -0,0 +1,160 @@
+// Measures decoded packets per second for the old per-transport decode (string + bitset vector + struct
+// copies for every packet) against the shared allocation-free decoder in packet.hpp
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run: ./decode-benchmark [packets]
+//
+
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+// Copy of the structs and decode that TCPServerHandler::onMessage and UDPServerHandler::run used to duplicate
+namespace legacy
+{
+    struct PacketData
+    {
+        std::string rawMessage;
+        std::vector<std::bitset<8>> rawBinary;
+    };
+
+    struct MotionPacketData : PacketData
+    {
+        int leftDrivePercent;
+        int rightDrivePercent;
+        ActuatorMotion actuator1;
+        ActuatorMotion actuator2;
+    };
+
+    struct MacroPacketData : PacketData
+    {
+        Macro macro;
+        bool pressed;
+        unsigned int data;
+    };
+
+    // Callbacks took the structs by value, so every packet paid for one more copy
+    template <typename T>
+    long consume(T data)
+    {
+        return (long)data.rawBinary.size();
+    }
+
+    long decode(const uint8_t *bytes, size_t length)
+    {
+        std::vector<std::bitset<8>> binary;
+        for (std::size_t i = 0; i < length; i++)
+        {
+            binary.push_back(std::bitset<8>(bytes[i]));
+        }
+
+        if (length == 2 && !(bytes[0] & 0b10000000))
+        {
+            bool triggers[4];
+            int leftWheelPercent, rightWheelPercent;
+            unsigned char temp = 0b01000000;
+            for (int i = 0; i < 4; i++)
+            {
+                triggers[i] = bytes[0] & temp;
+                temp >>= 1;
+            }
+
+            unsigned int leftMagnitude = (bytes[1] & 0b01110000) >> 4;
+            unsigned int rightMagnitude = bytes[1] & 0b00000111;
+            bool isLeftNegative = bytes[1] & 0b10000000;
+            bool isRightNegative = bytes[1] & 0b00001000;
+
+            leftWheelPercent = isLeftNegative ? -leftMagnitude : leftMagnitude;
+            rightWheelPercent = isRightNegative ? -rightMagnitude : rightMagnitude;
+
+            leftWheelPercent *= 14.28;
+            rightWheelPercent *= 14.28;
+
+            MotionPacketData data;
+            data.rawMessage = std::string((char *)bytes, length);
+            data.rawBinary = binary;
+            data.leftDrivePercent = leftWheelPercent;
+            data.rightDrivePercent = rightWheelPercent;
+            data.actuator1 = getActuatorMotion(triggers[2], triggers[0]);
+            data.actuator2 = getActuatorMotion(triggers[3], triggers[1]);
+            return consume(data) + data.leftDrivePercent + data.rightDrivePercent + data.actuator1 + data.actuator2;
+        }
+        else if ((length == 1 || length == 2) && bytes[0] & 0b10000000)
+        {
+            MacroPacketData data;
+            data.rawMessage = std::string((char *)bytes, length);
+            data.rawBinary = binary;
+            data.macro = Macro((bytes[0] & 0b01111100) >> 2);
+            data.pressed = bytes[0] & 0b00000010;
+            data.data = length == 2 ? bytes[1] : 0;
+            return consume(data) + data.macro + data.data;
+        }
+
+        return 0;
+    }
+}
+
+long decodeShared(const uint8_t *bytes, size_t length)
+{
+    MotionCommand motion;
+    MacroCommand macro;
+    switch (decodePacket(bytes, length, motion, macro))
+    {
+    case PacketType::MOTION:
+        return (long)length + motion.leftDrivePercent + motion.rightDrivePercent + motion.actuator1 + motion.actuator2;
+    case PacketType::MACRO:
+        return (long)length + macro.macro + macro.data;
+    default:
+        return 0;
+    }
+}
+
+// Runs <decode> over the packet set <iterations> times and prints packets per second
+// Both decoders fold the same fields into the checksum so the printed values should match
+template <typename Decode>
+double run(const char *name, const std::vector<std::vector<uint8_t>> &packets, long iterations, Decode decode)
+{
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++)
+    {
+        const std::vector<uint8_t> &packet = packets[i % packets.size()];
+        checksum += decode(packet.data(), packet.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double rate = iterations / elapsed.count();
+    std::cout << name << ":\t" << (long)rate << " packets/s\t(checksum " << checksum << ")" << std::endl;
+    return rate;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? std::atol(argv[1]) : 20000000;
+
+    // Every possible motion packet plus every macro packet with and without a data byte
+    std::vector<std::vector<uint8_t>> packets;
+    for (int b0 = 0; b0 < 0x80; b0 += 0x08)
+    {
+        for (int b1 = 0; b1 < 0x100; b1++)
+        {
+            packets.push_back({(uint8_t)b0, (uint8_t)b1});
+        }
+    }
+    for (int b0 = 0x80; b0 < 0x100; b0 += 2)
+    {
+        packets.push_back({(uint8_t)b0});
+        packets.push_back({(uint8_t)b0, 0x2a});
+    }
+
+    double before = run("legacy decode", packets, iterations, legacy::decode);
+    double after = run("shared decoder", packets, iterations, decodeShared);
+    std::cout << "speedup:\t" << after / before << "x" << std::endl;
+
+    return 0;
+}
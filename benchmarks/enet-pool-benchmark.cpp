@@ -0,0 +1,137 @@
+// Steady state allocations of an ENet server receiving a joystick stream (unsequenced motion) with reliable
+// control messages mixed in, first with ENet's default malloc/free and then with the slab pools from enetpool.hpp
+// Counts the calls that reach malloc per packet once the connection is warmed up, and the time per packet
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run: ./enet-pool-benchmark [packets]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <enet/enet.h>
+
+#include "enetpool.hpp"
+
+#define BENCHMARK_PORT 9105
+#define BURST 16         // Packets sent before the server drains them
+#define CONTROL_EVERY 8  // Every CONTROL_EVERY-th packet is a reliable control message
+#define WARMUP 2000
+
+static unsigned long mallocs = 0;
+
+static void *ENET_CALLBACK countingMalloc(size_t size)
+{
+    mallocs++;
+    return std::malloc(size);
+}
+
+static void ENET_CALLBACK countingFree(void *memory)
+{
+    std::free(memory);
+}
+
+struct Result
+{
+    double nanosPerPacket;
+    double mallocsPerPacket;
+};
+
+// Streams <packets> packets client to server over loopback, servicing both ends, returns the steady state figures
+// <heapCalls> returns how many calls reached malloc so far
+template <typename HeapCalls>
+static Result stream(long packets, HeapCalls heapCalls)
+{
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCHMARK_PORT;
+    ENetHost *server = enet_host_create(&address, 1, 2, 0, 0);
+    ENetHost *client = enet_host_create(NULL, 1, 2, 0, 0);
+    if (server == NULL || client == NULL)
+    {
+        std::cout << "Failed to create the ENet hosts\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    enet_address_set_host(&address, "127.0.0.1");
+    ENetPeer *peer = enet_host_connect(client, &address, 2, 0);
+    ENetEvent event;
+    for (int i = 0; i < 100 && peer->state != ENET_PEER_STATE_CONNECTED; i++)
+    {
+        enet_host_service(server, &event, 1);
+        enet_host_service(client, &event, 1);
+    }
+
+    long sent = 0;
+    auto run = [&](long count)
+    {
+        for (long i = 0; i < count; i++, sent++)
+        {
+            uint8_t motion[4] = {0x10, 0x73, (uint8_t)(sent >> 8), (uint8_t)sent};
+            if (sent % CONTROL_EVERY == 0)
+                enet_peer_send(peer, 1, enet_packet_create(motion, 2, ENET_PACKET_FLAG_RELIABLE));
+            else
+                enet_peer_send(peer, 0, enet_packet_create(motion, sizeof(motion), ENET_PACKET_FLAG_UNSEQUENCED));
+
+            if (i % BURST == BURST - 1)
+            {
+                enet_host_flush(client);
+                while (enet_host_service(server, &event, 0) > 0)
+                {
+                    if (event.type == ENET_EVENT_TYPE_RECEIVE)
+                        enet_packet_destroy(event.packet);
+                }
+                while (enet_host_service(client, &event, 0) > 0)
+                {
+                    if (event.type == ENET_EVENT_TYPE_RECEIVE)
+                        enet_packet_destroy(event.packet);
+                }
+            }
+        }
+    };
+
+    run(WARMUP);
+    unsigned long before = heapCalls();
+    auto start = std::chrono::steady_clock::now();
+    run(packets);
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    unsigned long calls = heapCalls() - before;
+
+    enet_peer_reset(peer);
+    enet_host_destroy(client);
+    enet_host_destroy(server);
+    return Result{(double)nanos / packets, (double)calls / packets};
+}
+
+int main(int argc, char **argv)
+{
+    const long packets = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    ENetCallbacks counting = {countingMalloc, countingFree, NULL};
+    enet_initialize_with_callbacks(ENET_VERSION, &counting);
+    Result heap = stream(packets, []()
+                         { return mallocs; });
+    enet_deinitialize();
+
+    // Both hosts were destroyed, nothing malloc'd above is left to be freed by the pools
+    EnetPool::initialize();
+    Result pooled = stream(packets, []()
+                           {
+                               unsigned long calls = EnetPool::heapAllocations().load();
+                               for (int i = 0; i < EnetPool::CLASS_COUNT; i++)
+                                   calls += EnetPool::pools()[i].getOverflows();
+                               return calls; });
+    enet_deinitialize();
+
+    std::cout << "Packets:  " << packets << " (client and server in this process)\n";
+    std::cout << "malloc:   " << heap.mallocsPerPacket << " mallocs/packet, " << heap.nanosPerPacket << " ns/packet\n";
+    std::cout << "Pools:    " << pooled.mallocsPerPacket << " mallocs/packet, " << pooled.nanosPerPacket << " ns/packet\n";
+    std::cout << "\nPool       slot  capacity  high water  allocations  overflows\n";
+    for (int i = 0; i < EnetPool::CLASS_COUNT; i++)
+    {
+        const SlabPool &pool = EnetPool::pools()[i];
+        std::cout << pool.name << "\t   " << pool.getSlotSize() << "\t " << pool.getCapacity() << "\t   " << pool.getHighWater()
+                  << "\t\t" << pool.getAllocations() << "\t     " << pool.getOverflows() << "\n";
+    }
+    return 0;
+}
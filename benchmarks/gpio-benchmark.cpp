@@ -0,0 +1,91 @@
+// Cost of the JETGPIO pin calls the motor controller makes on every command: gpioWrite, gpioWriteMask and GpioShadow
+// on the actuator pins, gpioRead on the limit switches, gpioSetMode, gpioPWM and gpioPWMDuty on the drive motor pins
+// Linked against jetgpio built with JETGPIO_SIMULATED, so the calls run the real library code against simulated
+// registers in memory instead of the Jetson's and the benchmark runs on any Linux machine
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, CMAKE_BUILD_TYPE=Release) and run: ./gpio-benchmark [calls]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <jetgpio.h>
+#include "gpioshadow.hpp"
+
+// Every header pin jetgpio can drive, calls cycle through them so each one pays its own lookup
+static const unsigned headerPins[] = {3, 5, 7, 8, 10, 11, 12, 13, 15, 16, 18, 19, 21, 22,
+                                      23, 24, 26, 27, 28, 29, 31, 32, 33, 35, 36, 37, 38, 40};
+#define HEADER_PIN_COUNT (sizeof(headerPins) / sizeof(headerPins[0]))
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Call>
+static double nanosPerCall(long calls, Call call)
+{
+    long result = 0;
+    auto start = Clock::now();
+    for (long i = 0; i < calls; i++)
+        result += call(i);
+    double nanos = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    if (result < 0)
+        std::printf("(a call failed)\n");
+    return nanos / calls;
+}
+
+int main(int argc, char **argv)
+{
+    const long calls = argc > 1 ? std::atol(argv[1]) : 10000000;
+
+    if (gpioInitialise() < 0)
+    {
+        std::printf("Failed to initialise jetgpio on the simulated registers\n");
+        return EXIT_FAILURE;
+    }
+
+    double setMode = nanosPerCall(calls / 10, [](long i)
+                                  { return gpioSetMode(headerPins[i % HEADER_PIN_COUNT], JET_OUTPUT) < 0 ? -1 : 0; });
+    double write = nanosPerCall(calls, [](long i)
+                                { return gpioWrite(headerPins[i % HEADER_PIN_COUNT], (i / HEADER_PIN_COUNT) & 1) < 0 ? -1 : 0; });
+    double read = nanosPerCall(calls, [](long i)
+                               { return gpioRead(headerPins[i % HEADER_PIN_COUNT]); });
+    // The last two header pins, the ones a switch on the pin number reaches last
+    double writeLast = nanosPerCall(calls, [](long i)
+                                    { return gpioWrite(i & 1 ? 40 : 38, (i >> 1) & 1) < 0 ? -1 : 0; });
+    double pwm = nanosPerCall(calls, [](long i)
+                              { return gpioPWM(i & 1 ? 33 : 32, i & 255) < 0 ? -1 : 0; });
+    gpioPWMConfigure(32);
+    gpioPWMConfigure(33);
+    double pwmDuty = nanosPerCall(calls, [](long i)
+                                  { return gpioPWMDuty(i & 1 ? 33 : 32, i & 255) < 0 ? -1 : 0; });
+
+    // Both actuators switching direction (pins 35, 36 and 28, 29 like MotorController), pin by pin and all at once
+    double actuatorWrites = nanosPerCall(calls, [](long i)
+                                         {
+                                             unsigned a = i & 1;
+                                             return gpioWrite(35, a) + gpioWrite(36, !a) + gpioWrite(28, a) + gpioWrite(29, !a) < 0 ? -1 : 0; });
+    double actuatorMask = nanosPerCall(calls, [](long i)
+                                       {
+                                           uint64_t pins = JET_PIN(35) | JET_PIN(36) | JET_PIN(28) | JET_PIN(29);
+                                           return gpioWriteMask(pins, i & 1 ? JET_PIN(35) | JET_PIN(28) : JET_PIN(36) | JET_PIN(29)) < 0 ? -1 : 0; });
+
+    // Motion packets mostly repeat the actuator state, the shadow only writes when it changes (every 64th call here)
+    GpioShadow shadow;
+    double actuatorShadow = nanosPerCall(calls, [&shadow](long i)
+                                         {
+                                             uint64_t pins = JET_PIN(35) | JET_PIN(36) | JET_PIN(28) | JET_PIN(29);
+                                             return shadow.writeMask(pins, (i >> 6) & 1 ? JET_PIN(35) | JET_PIN(28) : JET_PIN(36) | JET_PIN(29)) < 0 ? -1 : 0; });
+
+    std::printf("gpioSetMode:               %.2f ns/call\n", setMode);
+    std::printf("gpioWrite (every pin):     %.2f ns/call\n", write);
+    std::printf("gpioWrite (pins 38, 40):   %.2f ns/call\n", writeLast);
+    std::printf("gpioRead (every pin):      %.2f ns/call\n", read);
+    std::printf("gpioPWM (pins 32, 33):     %.2f ns/call\n", pwm);
+    std::printf("gpioPWMDuty (pins 32, 33): %.2f ns/call\n", pwmDuty);
+    std::printf("Actuators, 4 gpioWrite:    %.2f ns\n", actuatorWrites);
+    std::printf("Actuators, gpioWriteMask:  %.2f ns\n", actuatorMask);
+    std::printf("Actuators, GpioShadow:     %.2f ns (%lu pin writes, %lu skipped)\n", actuatorShadow, shadow.getPerformed(), shadow.getSkipped());
+
+    gpioTerminate();
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Drives the real MotorController on simulated jetgpio registers and checks the register values it leaves behind:
+// pin directions, actuator output levels and the drive motors' PWM registers
+// Exits with 1 if any register is wrong
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run: ./gpio-register-check
+//  Set JETGPIO_REGISTER_FILE=<path> to keep the registers in a file, the check then also reads them back from it
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <jetgpio.h>
+#include "motor.hpp"
+
+// Offset of each register block in JETGPIO_REGISTER_FILE, in the order nano.c lays them out
+static const uint32_t registerBlocks[] = {base_CNF, base_PINMUX, base_CFG, base_PWM, CAR, base_PMC};
+
+static int failures = 0;
+static int registerFile = -1;
+
+// Reads the register at physical <address> from the file backing the simulated registers
+static bool readRegisterFile(uint32_t address, uint32_t &value)
+{
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    for (std::size_t i = 0; i < sizeof(registerBlocks) / sizeof(registerBlocks[0]); i++)
+    {
+        if (address >= registerBlocks[i] && address < registerBlocks[i] + pageSize)
+            return pread(registerFile, &value, sizeof(value), i * pageSize + (address - registerBlocks[i])) == sizeof(value);
+    }
+    return false;
+}
+
+static void expect(const char *what, uint32_t address, uint32_t mask, uint32_t expected)
+{
+    volatile uint32_t *reg = gpioSimulatedRegister(address);
+    uint32_t value = reg != nullptr ? *reg : 0;
+    bool ok = reg != nullptr && (value & mask) == expected;
+
+    uint32_t fileValue = value;
+    if (registerFile >= 0 && (!readRegisterFile(address, fileValue) || fileValue != value))
+        ok = false;
+
+    std::printf("%-4s %-40s 0x%08x & 0x%08x = 0x%08x (expected 0x%08x)\n", ok ? "ok" : "FAIL", what, value, mask, value & mask, expected);
+    if (!ok)
+        failures++;
+}
+
+static uint32_t outRegister(uint32_t cnf) { return base_CNF + cnf + offsetof(GPIO_CNF, OUT); }
+static uint32_t oeRegister(uint32_t cnf) { return base_CNF + cnf + offsetof(GPIO_CNF, OE); }
+
+// Value MotorController's drive motors should leave in a PWM register for <duty>
+static uint32_t pwmValue(uint32_t duty)
+{
+    const uint32_t frequencyDivider = std::lround(187500.0 / PWM_FREQUENCY) - 1;
+    return 0x80000000 | duty << 16 | frequencyDivider;
+}
+
+int main()
+{
+    const char *path = std::getenv("JETGPIO_REGISTER_FILE");
+    if (path != nullptr)
+        unlink(path); // Start from zeroed registers
+
+    if (gpioInitialise() < 0)
+    {
+        std::printf("Failed to initialise jetgpio on simulated registers\n");
+        return EXIT_FAILURE;
+    }
+    if (path != nullptr)
+        registerFile = open(path, O_RDONLY);
+
+    const int stopDuty = 0.0015 * PWM_FREQUENCY * 256;
+    const int partitions = 0.0005 * PWM_FREQUENCY * 256;
+    {
+        MotorController motors;
+
+        std::printf("After construction\n");
+        expect("pin 32 PWM (right drive) stopped", base_PWM + PM3_PWM0, 0xFFFFFFFF, pwmValue(stopDuty));
+        expect("pin 33 PWM (left drive) stopped", base_PWM + PM3_PWM2, 0xFFFFFFFF, pwmValue(stopDuty));
+        expect("pin 32 routed to PWM", base_PINMUX + PINMUX_32, 0xFFFFFFFF, 0x00000001);
+        expect("pin 33 routed to PWM", base_PINMUX + PINMUX_33, 0xFFFFFFFF, 0x00000002);
+        expect("pin 35 output", oeRegister(CNF_35), 0x10, 0x10);
+        expect("pin 36 output", oeRegister(CNF_36), 0x08, 0x08);
+        expect("pin 28 output", oeRegister(CNF_28), 0x02, 0x02);
+        expect("pin 29 output", oeRegister(CNF_29), 0x20, 0x20);
+
+        std::printf("Actuator 1 extending, actuator 2 retracting, full speed forwards left and backwards right\n");
+        motors.setActuators(ActuatorMotion::EXTENDING, ActuatorMotion::RETRACTING);
+        motors.setDrivePercent(100, -100);
+        expect("pin 35 (actuator 1 a) high", outRegister(CNF_35), 0x10, 0x10);
+        expect("pin 36 (actuator 1 b) low", outRegister(CNF_36), 0x08, 0x00);
+        expect("pin 28 (actuator 2 a) low", outRegister(CNF_28), 0x02, 0x00);
+        expect("pin 29 (actuator 2 b) high", outRegister(CNF_29), 0x20, 0x20);
+        expect("pin 33 PWM (left drive) forwards", base_PWM + PM3_PWM2, 0xFFFFFFFF, pwmValue(stopDuty + partitions));
+        expect("pin 32 PWM (right drive) backwards", base_PWM + PM3_PWM0, 0xFFFFFFFF, pwmValue(stopDuty - partitions));
+
+        std::printf("Actuator 1 retracting, actuator 2 extending\n");
+        motors.setActuators(ActuatorMotion::RETRACTING, ActuatorMotion::EXTENDING);
+        expect("pin 35 (actuator 1 a) low", outRegister(CNF_35), 0x10, 0x00);
+        expect("pin 36 (actuator 1 b) high", outRegister(CNF_36), 0x08, 0x08);
+        expect("pin 28 (actuator 2 a) high", outRegister(CNF_28), 0x02, 0x02);
+        expect("pin 29 (actuator 2 b) low", outRegister(CNF_29), 0x20, 0x00);
+
+        std::printf("Stopped\n");
+        motors.stopMovement();
+        expect("pins 35 and 28 high", outRegister(CNF_35), 0x12, 0x12);
+        expect("pin 36 high", outRegister(CNF_36), 0x08, 0x08);
+        expect("pin 29 high", outRegister(CNF_29), 0x20, 0x20);
+        expect("pin 33 PWM (left drive) stopped", base_PWM + PM3_PWM2, 0xFFFFFFFF, pwmValue(stopDuty));
+        expect("pin 32 PWM (right drive) stopped", base_PWM + PM3_PWM0, 0xFFFFFFFF, pwmValue(stopDuty));
+    }
+
+    std::printf("%s, %d wrong\n", failures == 0 ? "All registers as expected" : "Some registers are wrong", failures);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
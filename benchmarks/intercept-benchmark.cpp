@@ -0,0 +1,136 @@
+// Measures the server side cost per motion datagram of a normal ENet packet (command parsing, peer lookup,
+// ENetPacket allocation, event dispatch) against a fast motion datagram decoded by ENetHost::intercept
+// Client and server run in this process over loopback, only the time spent servicing the server is counted
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run: ./intercept-benchmark [datagrams]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <enet/enet.h>
+
+#include "packet.hpp"
+#include "fastmotion.hpp"
+
+#define BENCHMARK_PORT 9102
+#define BATCH_SIZE 64 // Datagrams sent before the server drains them, small enough for the socket buffer
+
+static const uint8_t KEY[FastMotion::KEY_LENGTH] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+static long checksum = 0;
+static long received = 0;
+
+static void consume(const uint8_t *bytes, std::size_t length)
+{
+    MotionCommand motion;
+    MacroCommand macro;
+    if (decodePacket(bytes, length, motion, macro) == PacketType::MOTION)
+        checksum += motion.leftDrivePercent + motion.rightDrivePercent;
+    received++;
+}
+
+static int ENET_CALLBACK intercept(ENetHost *host, ENetEvent *)
+{
+    uint8_t packet[MAX_MOTION_PACKET_LENGTH];
+    if (!isFastMotion(host->receivedData, host->receivedDataLength) || !decodeFastMotion(host->receivedData, KEY, packet))
+        return 0;
+    consume(packet, sizeof(packet));
+    return 1;
+}
+
+// Services the server until <count> more motion packets arrived, returns the time it took in ns
+static int64_t drain(ENetHost *server, long count)
+{
+    const long target = received + count;
+    ENetEvent event;
+    auto start = std::chrono::steady_clock::now();
+    while (received < target && enet_host_service(server, &event, 0) >= 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        {
+            consume(event.packet->data, event.packet->dataLength);
+            enet_packet_destroy(event.packet);
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    const long datagrams = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    enet_initialize();
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCHMARK_PORT;
+    ENetHost *server = enet_host_create(&address, 1, 2, 0, 0);
+    ENetHost *client = enet_host_create(NULL, 1, 2, 0, 0);
+    if (server == NULL || client == NULL)
+    {
+        std::cout << "Failed to create the ENet hosts\n";
+        return EXIT_FAILURE;
+    }
+
+    enet_address_set_host(&address, "127.0.0.1");
+    ENetPeer *peer = enet_host_connect(client, &address, 2, 0);
+    ENetEvent event;
+    for (int i = 0; i < 100 && peer->state != ENET_PEER_STATE_CONNECTED; i++)
+    {
+        enet_host_service(server, &event, 1);
+        enet_host_service(client, &event, 1);
+    }
+    if (peer->state != ENET_PEER_STATE_CONNECTED)
+    {
+        std::cout << "Failed to connect over loopback\n";
+        return EXIT_FAILURE;
+    }
+
+    // Normal ENet path, one unsequenced packet per datagram like a joystick stream
+    int64_t enetNs = 0;
+    uint16_t sequence = 0;
+    for (long sent = 0; sent < datagrams; sent += BATCH_SIZE)
+    {
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            uint8_t motion[MAX_MOTION_PACKET_LENGTH] = {0x10, (uint8_t)(sequence & 0x77)};
+            setMotionSequence(motion, sequence++);
+            enet_peer_send(peer, 0, enet_packet_create(motion, sizeof(motion), ENET_PACKET_FLAG_UNSEQUENCED));
+            enet_host_flush(client);
+        }
+        enetNs += drain(server, BATCH_SIZE);
+    }
+    const long enetChecksum = checksum;
+
+    // Fast path, the same motion sent as raw signed datagrams from the client's socket
+    server->intercept = intercept;
+    checksum = 0;
+    int64_t fastNs = 0;
+    sequence = 0;
+    for (long sent = 0; sent < datagrams; sent += BATCH_SIZE)
+    {
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            uint8_t motion[2] = {0x10, (uint8_t)(sequence & 0x77)};
+            uint8_t datagram[FastMotion::LENGTH];
+            encodeFastMotion(datagram, motion, sequence++, KEY);
+            ENetBuffer buffer;
+            buffer.data = datagram;
+            buffer.dataLength = sizeof(datagram);
+            enet_socket_send(client->socket, &address, &buffer, 1);
+        }
+        fastNs += drain(server, BATCH_SIZE);
+    }
+
+    const long rounded = (datagrams + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+    std::cout << "Datagrams:           " << rounded << "\n";
+    std::cout << "ENet packets:        " << (double)enetNs / rounded << " ns/datagram\n";
+    std::cout << "Intercept fast path: " << (double)fastNs / rounded << " ns/datagram\n";
+    std::cout << "Checksums:           " << enetChecksum << " / " << checksum << (enetChecksum == checksum ? " (match)" : " (MISMATCH)") << "\n";
+
+    enet_peer_reset(peer);
+    enet_host_destroy(client);
+    enet_host_destroy(server);
+    enet_deinitialize();
+    return 0;
+}
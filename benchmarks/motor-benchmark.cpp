@@ -0,0 +1,64 @@
+// Cost of applying one motion command with the real MotorController (setDrivePercent and setActuators, what the
+// actuation thread does for every packet) on simulated jetgpio registers
+// Runs a stream where the drive percents change on every command and the actuators every <change interval> commands,
+// like a driver holding the sticks, plus a stream that repeats the same command
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, CMAKE_BUILD_TYPE=Release) and run:
+//      ./motor-benchmark [commands] [actuator change interval]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "motor.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Command>
+static double nanosPerCommand(MotorController &motors, long commands, Command command)
+{
+    const unsigned long performedBefore = gpioShadow().getPerformed();
+    const unsigned long skippedBefore = gpioShadow().getSkipped();
+
+    auto start = Clock::now();
+    for (long i = 0; i < commands; i++)
+        command(motors, i);
+    double nanos = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    std::printf("  %.2f pin writes and %.2f skipped per command\n", (double)(gpioShadow().getPerformed() - performedBefore) / commands,
+                (double)(gpioShadow().getSkipped() - skippedBefore) / commands);
+    return nanos / commands;
+}
+
+int main(int argc, char **argv)
+{
+    const long commands = argc > 1 ? std::atol(argv[1]) : 10000000;
+    const long changeInterval = argc > 2 ? std::atol(argv[2]) : 50;
+
+    if (gpioInitialise() < 0)
+    {
+        std::printf("Failed to initialise jetgpio on simulated registers\n");
+        return EXIT_FAILURE;
+    }
+
+    MotorController motors;
+    const ActuatorMotion motions[] = {ActuatorMotion::NONE, ActuatorMotion::EXTENDING, ActuatorMotion::RETRACTING};
+
+    std::printf("Driving, actuators changing every %ld commands\n", changeInterval);
+    double driving = nanosPerCommand(motors, commands, [changeInterval, &motions](MotorController &motors, long i)
+                                     {
+                                         int percent = (int)(i % 201) - 100;
+                                         motors.setDrivePercent(percent, -percent);
+                                         ActuatorMotion motion = motions[(i / changeInterval) % 3];
+                                         motors.setActuators(motion, motion); });
+
+    std::printf("Repeating one command\n");
+    double repeating = nanosPerCommand(motors, commands, [](MotorController &motors, long)
+                                       {
+                                           motors.setDrivePercent(50, 50);
+                                           motors.setActuators(ActuatorMotion::EXTENDING, ActuatorMotion::NONE); });
+
+    std::printf("Driving:   %.2f ns/command\n", driving);
+    std::printf("Repeating: %.2f ns/command\n", repeating);
+    return 0;
+}
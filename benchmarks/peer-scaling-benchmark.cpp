@@ -0,0 +1,133 @@
+// Cost of servicing an ENet server as the number of allocated peers grows while the number of connected clients
+// stays the same, like raising the peer limit for telemetry spectators who mostly never show up
+// Measures an idle enet_host_service (timeouts, pings and acknowledgements for every active peer), a flush after
+// broadcasting to every connected client, and looking a peer up by address (the fast motion path) against a scan
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, CMAKE_BUILD_TYPE=Release) and run: ./peer-scaling-benchmark [calls]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <enet/enet.h>
+
+#define BENCHMARK_PORT 9106
+#define CONNECTED 16
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Call>
+static double nanosPerCall(long calls, Call call)
+{
+    auto start = Clock::now();
+    for (long i = 0; i < calls; i++)
+        call(i);
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count() / calls;
+}
+
+static void drain(ENetHost *host)
+{
+    ENetEvent event;
+    while (enet_host_service(host, &event, 0) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+            enet_packet_destroy(event.packet);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const long calls = argc > 1 ? std::atol(argv[1]) : 20000;
+    const size_t peerCounts[] = {32, 64, 128, 256, 512, 1024};
+
+    enet_initialize();
+    std::printf("Peers  Connected  Idle service ns  Broadcast flush ns  Address lookup ns  Scan ns\n");
+    for (size_t peerCount : peerCounts)
+    {
+        ENetAddress address;
+        address.host = ENET_HOST_ANY;
+        address.port = BENCHMARK_PORT;
+        ENetHost *server = enet_host_create(&address, peerCount, 2, 0, 0);
+        if (server == NULL)
+        {
+            std::printf("Failed to create the ENet server host\n");
+            return EXIT_FAILURE;
+        }
+
+        // Connected clients take the last slots, where a scan of the peer array finds them last
+        for (size_t i = 0; i < peerCount - CONNECTED; i++)
+            server->peers[i].state = ENET_PEER_STATE_ZOMBIE;
+
+        enet_address_set_host(&address, "127.0.0.1");
+        std::vector<ENetHost *> clients;
+        for (int i = 0; i < CONNECTED; i++)
+        {
+            clients.push_back(enet_host_create(NULL, 1, 2, 0, 0));
+            enet_host_connect(clients.back(), &address, 2, 0);
+        }
+        for (int i = 0; i < 200 && server->connectedPeers < CONNECTED; i++)
+        {
+            ENetEvent event;
+            enet_host_service(server, &event, 1);
+            for (ENetHost *client : clients)
+                drain(client);
+        }
+        for (size_t i = 0; i < peerCount - CONNECTED; i++)
+            server->peers[i].state = ENET_PEER_STATE_DISCONNECTED;
+
+        double idle = nanosPerCall(calls, [server](long)
+                                   {
+                                       ENetEvent event;
+                                       enet_host_service(server, &event, 0); });
+
+        // Time only the flush that walks the peers and sends one datagram to each connected client
+        uint8_t payload[32] = {};
+        int64_t flushNs = 0;
+        const long broadcasts = calls / 10;
+        for (long i = 0; i < broadcasts; i++)
+        {
+            enet_host_broadcast(server, 0, enet_packet_create(payload, sizeof(payload), ENET_PACKET_FLAG_UNSEQUENCED));
+            auto start = Clock::now();
+            enet_host_flush(server);
+            flushNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            if (i % 16 == 15)
+                for (ENetHost *client : clients)
+                    drain(client);
+        }
+        double broadcast = (double)flushNs / broadcasts;
+
+        std::vector<ENetAddress> addresses;
+        for (ENetHost *client : clients)
+            drain(client);
+        for (ENetPeer *peer = server->peers; peer < &server->peers[peerCount]; ++peer)
+            if (peer->state == ENET_PEER_STATE_CONNECTED)
+                addresses.push_back(peer->address);
+
+        size_t found = 0;
+        double lookup = nanosPerCall(calls * 10, [server, &addresses, &found](long i)
+                                     { found += enet_host_find_peer(server, &addresses[i % addresses.size()]) != NULL; });
+        double scan = nanosPerCall(calls * 10, [server, &addresses, &found](long i)
+                                   {
+                                       const ENetAddress &address = addresses[i % addresses.size()];
+                                       for (ENetPeer *peer = server->peers; peer < &server->peers[server->peerCount]; ++peer)
+                                       {
+                                           if (peer->state == ENET_PEER_STATE_CONNECTED && peer->address.host == address.host && peer->address.port == address.port)
+                                           {
+                                               found++;
+                                               break;
+                                           }
+                                       } });
+
+        std::printf("%-6zu %-10zu %-16.0f %-19.0f %-18.1f %.1f%s\n", peerCount, server->connectedPeers, idle, broadcast, lookup, scan,
+                    found == (size_t)calls * 20 ? "" : "  (LOOKUP FAILED)");
+
+        for (ENetHost *client : clients)
+            enet_host_destroy(client);
+        enet_host_destroy(server);
+    }
+
+    enet_deinitialize();
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Cost of sending a burst of small reliable messages to a client, like the status replies a command produces
+// Compares copying every message into a new packet and flushing after each one (what sendString used to do)
+// against packets that point at the caller's buffer (ENET_PACKET_FLAG_NO_ALLOCATE) flushed once per burst
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run: ./send-benchmark [bursts] [messages per burst]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <enet/enet.h>
+
+#define BENCHMARK_PORT 9107
+#define MESSAGE_LENGTH 48
+
+typedef std::chrono::steady_clock Clock;
+
+static unsigned long released = 0;
+
+static void ENET_CALLBACK countRelease(ENetPacket *)
+{
+    released++;
+}
+
+static void drain(ENetHost *host)
+{
+    ENetEvent event;
+    while (enet_host_service(host, &event, 0) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+            enet_packet_destroy(event.packet);
+    }
+}
+
+// Sends <bursts> bursts of <messages> messages, returns ns per message and sets <datagrams> to the datagrams sent
+template <typename Send>
+static double nanosPerMessage(ENetHost *server, ENetHost *client, long bursts, int messages, enet_uint32 &datagrams, Send send)
+{
+    const enet_uint32 sentBefore = server->totalSentPackets;
+    int64_t nanos = 0;
+    for (long i = 0; i < bursts; i++)
+    {
+        auto start = Clock::now();
+        send(messages);
+        nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+        // Let the acknowledgements come back so the reliable window never fills up
+        drain(client);
+        drain(server);
+    }
+    datagrams = server->totalSentPackets - sentBefore;
+    return (double)nanos / (bursts * messages);
+}
+
+int main(int argc, char **argv)
+{
+    const long bursts = argc > 1 ? std::atol(argv[1]) : 20000;
+    const int messages = argc > 2 ? std::atoi(argv[2]) : 8;
+
+    enet_initialize();
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCHMARK_PORT;
+    ENetHost *server = enet_host_create(&address, 1, 2, 0, 0);
+    ENetHost *client = enet_host_create(NULL, 1, 2, 0, 0);
+    if (server == NULL || client == NULL)
+    {
+        std::printf("Failed to create the ENet hosts\n");
+        return EXIT_FAILURE;
+    }
+
+    enet_address_set_host(&address, "127.0.0.1");
+    enet_host_connect(client, &address, 2, 0);
+    for (int i = 0; i < 200 && server->connectedPeers == 0; i++)
+    {
+        ENetEvent event;
+        enet_host_service(server, &event, 1);
+        drain(client);
+    }
+    if (server->connectedPeers == 0)
+    {
+        std::printf("The client didn't connect\n");
+        return EXIT_FAILURE;
+    }
+
+    uint8_t message[MESSAGE_LENGTH] = {};
+
+    enet_uint32 copiedDatagrams;
+    double copied = nanosPerMessage(server, client, bursts, messages, copiedDatagrams, [server, &message](int count)
+                                    {
+                                        for (int i = 0; i < count; i++)
+                                        {
+                                            enet_host_broadcast(server, 1, enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_RELIABLE));
+                                            enet_host_flush(server);
+                                        } });
+
+    enet_uint32 borrowedDatagrams;
+    double borrowed = nanosPerMessage(server, client, bursts, messages, borrowedDatagrams, [server, &message](int count)
+                                      {
+                                          for (int i = 0; i < count; i++)
+                                          {
+                                              ENetPacket *packet = enet_packet_create(message, sizeof(message), ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_NO_ALLOCATE);
+                                              packet->freeCallback = countRelease;
+                                              enet_host_broadcast(server, 1, packet);
+                                          }
+                                          enet_host_flush(server); });
+
+    // Every packet has to be given back, or the caller could never reuse its buffer
+    drain(client);
+    drain(server);
+    const unsigned long expected = (unsigned long)bursts * messages;
+
+    std::printf("%d messages of %d bytes per burst\n", messages, MESSAGE_LENGTH);
+    std::printf("copy, flush each:        %.0f ns/message, %.2f datagrams/burst\n", copied, (double)copiedDatagrams / bursts);
+    std::printf("no copy, flush at end:   %.0f ns/message, %.2f datagrams/burst%s\n", borrowed, (double)borrowedDatagrams / bursts,
+                released == expected ? "" : "  (NOT EVERY BUFFER WAS RELEASED)");
+
+    enet_host_destroy(client);
+    enet_host_destroy(server);
+    enet_deinitialize();
+    return 0;
+}
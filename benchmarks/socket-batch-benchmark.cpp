@@ -0,0 +1,142 @@
+// Loopback throughput of an ENet server with 32 connected peers, for the two cases batched socket calls help:
+// broadcasting to every peer (one datagram per peer per flush) and draining a burst of datagrams from every peer
+// Built twice, against ENet with recvmmsg/sendmmsg batches and against ENet with ENET_SOCKET_BATCH_SIZE 1
+// (one system call per datagram like stock ENet), compare the output of the two
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON) and run:
+//      ./socket-batch-benchmark [rounds]
+//      ./socket-batch-benchmark-unbatched [rounds]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <enet/enet.h>
+
+#define BENCHMARK_PORT 9103
+#define PEERS 32
+#define BURST 4         // Datagrams each peer sends per receive round
+#define PAYLOAD_SIZE 64 // Bytes per packet, about a status message
+
+typedef std::chrono::steady_clock Clock;
+
+static int64_t nanosSince(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Services every client, throwing away what they received
+static void drainClients(std::vector<ENetHost *> &clients)
+{
+    ENetEvent event;
+    for (ENetHost *client : clients)
+    {
+        while (enet_host_service(client, &event, 0) > 0)
+        {
+            if (event.type == ENET_EVENT_TYPE_RECEIVE)
+                enet_packet_destroy(event.packet);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 5000;
+
+    enet_initialize();
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCHMARK_PORT;
+    ENetHost *server = enet_host_create(&address, PEERS, 2, 0, 0);
+    if (server == NULL)
+    {
+        std::cout << "Failed to create the ENet server host\n";
+        return EXIT_FAILURE;
+    }
+
+    enet_address_set_host(&address, "127.0.0.1");
+    std::vector<ENetHost *> clients;
+    std::vector<ENetPeer *> peers;
+    for (int i = 0; i < PEERS; i++)
+    {
+        ENetHost *client = enet_host_create(NULL, 1, 2, 0, 0);
+        clients.push_back(client);
+        peers.push_back(enet_host_connect(client, &address, 2, 0));
+    }
+
+    ENetEvent event;
+    for (int i = 0; i < 200 && server->connectedPeers < PEERS; i++)
+    {
+        while (enet_host_service(server, &event, 1) > 0)
+        {
+        }
+        drainClients(clients);
+    }
+    if (server->connectedPeers < PEERS)
+    {
+        std::cout << "Only " << server->connectedPeers << " of " << PEERS << " peers connected\n";
+        return EXIT_FAILURE;
+    }
+
+    uint8_t payload[PAYLOAD_SIZE] = {};
+
+    // Broadcast, time only the server flush that turns one packet into a datagram per peer
+    int64_t broadcastNs = 0;
+    for (long round = 0; round < rounds; round++)
+    {
+        enet_host_broadcast(server, 0, enet_packet_create(payload, sizeof(payload), ENET_PACKET_FLAG_UNSEQUENCED));
+        Clock::time_point start = Clock::now();
+        enet_host_flush(server);
+        broadcastNs += nanosSince(start);
+
+        if (round % 8 == 7)
+            drainClients(clients);
+    }
+    drainClients(clients);
+
+    // Burst receive, every peer sends BURST datagrams and the server drains them all
+    int64_t receiveNs = 0;
+    long received = 0;
+    for (long round = 0; round < rounds; round++)
+    {
+        for (ENetPeer *peer : peers)
+        {
+            for (int i = 0; i < BURST; i++)
+            {
+                enet_peer_send(peer, 0, enet_packet_create(payload, sizeof(payload), ENET_PACKET_FLAG_UNSEQUENCED));
+                enet_host_flush(peer->host);
+            }
+        }
+
+        const long target = received + PEERS * BURST;
+        Clock::time_point start = Clock::now();
+        while (received < target && enet_host_service(server, &event, 0) >= 0)
+        {
+            if (event.type == ENET_EVENT_TYPE_RECEIVE)
+            {
+                received++;
+                enet_packet_destroy(event.packet);
+            }
+            else if (event.type == ENET_EVENT_TYPE_NONE && nanosSince(start) > 1000000000)
+            {
+                break; // Lost on loopback, don't wait forever
+            }
+        }
+        receiveNs += nanosSince(start);
+    }
+
+    std::cout << "Socket batch size: " << ENET_SOCKET_BATCH_SIZE << "\n";
+    std::cout << "Broadcast to " << PEERS << ":   " << (double)broadcastNs / rounds << " ns/flush, "
+              << (double)broadcastNs / (rounds * PEERS) << " ns/datagram\n";
+    std::cout << "Burst receive:     " << (double)receiveNs / received << " ns/datagram ("
+              << received << " of " << rounds * PEERS * BURST << " received)\n";
+    std::cout << "Receive rate:      " << received * 1e9 / receiveNs / 1000 << " k datagrams/s\n";
+
+    for (ENetHost *client : clients)
+        enet_host_destroy(client);
+    enet_host_destroy(server);
+    enet_deinitialize();
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Measures the cost of one socket wakeup, the wait enet_host_service does on every call, when a datagram is
+// already waiting (always the case at high packet rates): select with fd_set rebuilt every call (stock ENet),
+// poll, epoll_wait on a descriptor registered once, and enet_host_wait through the backend ENet was built with
+//
+//  Build with the main project (BUILD_BENCHMARKS=ON, ENET_WAIT_BACKEND=select|poll|epoll) and run:
+//      ./wait-benchmark [calls]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include <enet/enet.h>
+
+#define BENCHMARK_PORT 9104
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Wait>
+static double nanosPerCall(long calls, Wait wait)
+{
+    long ready = 0;
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < calls; i++)
+    {
+        ready += wait();
+    }
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    if (ready != calls)
+        std::cout << "(socket was not readable on " << calls - ready << " calls)\n";
+    return (double)nanos / calls;
+}
+
+int main(int argc, char **argv)
+{
+    const long calls = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    enet_initialize();
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCHMARK_PORT;
+    ENetHost *server = enet_host_create(&address, 1, 2, 0, 0);
+    ENetHost *client = enet_host_create(NULL, 1, 2, 0, 0);
+    if (server == NULL || client == NULL)
+    {
+        std::cout << "Failed to create the ENet hosts\n";
+        return EXIT_FAILURE;
+    }
+
+    // Leave one datagram unread on the server socket so every wait returns right away
+    enet_address_set_host(&address, "127.0.0.1");
+    uint8_t datagram[16] = {};
+    ENetBuffer buffer;
+    buffer.data = datagram;
+    buffer.dataLength = sizeof(datagram);
+    enet_socket_send(client->socket, &address, &buffer, 1);
+    usleep(10000);
+
+    const int fd = server->socket;
+
+    double selectNs = nanosPerCall(calls, [fd]()
+                                   {
+                                       fd_set readSet;
+                                       FD_ZERO(&readSet);
+                                       FD_SET(fd, &readSet);
+                                       timeval timeout = {0, 0};
+                                       return select(fd + 1, &readSet, NULL, NULL, &timeout) > 0 && FD_ISSET(fd, &readSet); });
+
+    double pollNs = nanosPerCall(calls, [fd]()
+                                 {
+                                     pollfd pollSocket = {fd, POLLIN, 0};
+                                     return poll(&pollSocket, 1, 0) > 0 && (pollSocket.revents & POLLIN); });
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event registration = {};
+    registration.events = EPOLLIN;
+    registration.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &registration);
+    double epollNs = nanosPerCall(calls, [epollFd]()
+                                  {
+                                      epoll_event event;
+                                      return epoll_wait(epollFd, &event, 1, 0) > 0; });
+    close(epollFd);
+
+    double hostNs = nanosPerCall(calls, [server]()
+                                 {
+                                     enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
+                                     return enet_host_wait(server, &condition, 0) == 0 && (condition & ENET_SOCKET_WAIT_RECEIVE); });
+
+    std::cout << "select:          " << selectNs << " ns/wakeup\n";
+    std::cout << "poll:            " << pollNs << " ns/wakeup\n";
+    std::cout << "epoll_wait:      " << epollNs << " ns/wakeup\n";
+    std::cout << "enet_host_wait:  " << hostNs << " ns/wakeup (" << (server->waitDescriptor >= 0 ? "epoll" : "select or poll") << " backend)\n";
+
+    enet_host_destroy(client);
+    enet_host_destroy(server);
+    enet_deinitialize();
+    return 0;
+}
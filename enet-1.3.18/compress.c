@@ -1,9 +1,10 @@
 /** 
  @file compress.c
- @brief An adaptive order-2 PPM range coder
+ @brief An adaptive order-2 PPM range coder and a fast LZ compressor
 */
 #define ENET_BUILDING_LIB 1
 #include <string.h>
+#include "enet/utility.h"
 #include "enet/enet.h"
 
 typedef struct _ENetSymbol
@@ -626,10 +627,320 @@ enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t i
     return (size_t) (outData - outStart);
 }
 
+/* LZ compressor: each datagram is a series of sequences, a literal run followed by a back reference
+   <token> [literal length bytes] <literals> <offset (1 or 2)> [match length bytes]
+   The token's high nibble holds the literal length and the low nibble the match length minus
+   ENET_LZ_MINIMUM_MATCH, either saturates at 15 and continues in bytes of 255 ended by one below 255.
+   The offset is 0 to repeat the previous sequence's offset, (offset << 1 | 1) below 128, or else
+   (offset << 2 | 2) over two little endian bytes. Frames of the same layout queued into one datagram
+   repeat at the same distance, with only a few changed fields between the matches, so the one byte
+   repeat code carries most of them.
+   The last sequence stops after its literals. Nothing is kept between datagrams, so a lost one
+   never affects the next. */
+enum
+{
+    ENET_LZ_HASH_BITS     = 10,
+    ENET_LZ_MINIMUM_MATCH = 4,
+    ENET_LZ_RUN_MASK      = 15,
+    ENET_LZ_SHORT_OFFSET  = 128,
+    ENET_LZ_MAXIMUM_OFFSET = 1 << 14
+};
+
+typedef struct _ENetLZ
+{
+    /* the datagram gathered from its buffers, back references may reach anywhere before the cursor */
+    enet_uint8 input [ENET_PROTOCOL_MAXIMUM_MTU];
+    /* last position each 4 byte hash was seen at, stale entries from earlier datagrams are harmless
+       since every candidate is compared before it is used */
+    enet_uint16 positions [1 << ENET_LZ_HASH_BITS];
+} ENetLZ;
+
+void *
+enet_lz_create (void)
+{
+    ENetLZ * lz = (ENetLZ *) enet_malloc (sizeof (ENetLZ));
+    if (lz == NULL)
+      return NULL;
+
+    memset (lz -> positions, 0, sizeof (lz -> positions));
+
+    return lz;
+}
+
+void
+enet_lz_destroy (void * context)
+{
+    ENetLZ * lz = (ENetLZ *) context;
+    if (lz == NULL)
+      return;
+
+    enet_free (lz);
+}
+
+static enet_uint32
+enet_lz_hash (const enet_uint8 * data)
+{
+    enet_uint32 value = (enet_uint32) data [0] | ((enet_uint32) data [1] << 8) | ((enet_uint32) data [2] << 16) | ((enet_uint32) data [3] << 24);
+
+    return (value * 2654435761U) >> (32 - ENET_LZ_HASH_BITS);
+}
+
+static enet_uint8 *
+enet_lz_output_length (enet_uint8 * outData, const enet_uint8 * outEnd, size_t length)
+{
+    for (;;)
+    {
+        if (outData >= outEnd)
+          return NULL;
+
+        if (length < 255)
+          break;
+
+        * outData ++ = 255;
+        length -= 255;
+    }
+
+    * outData ++ = (enet_uint8) length;
+
+    return outData;
+}
+
+/* Writes one sequence, a matchLength of 0 marks the last one. Returns NULL if it doesn't fit. */
+static enet_uint8 *
+enet_lz_output_sequence (enet_uint8 * outData, const enet_uint8 * outEnd, const enet_uint8 * literals, size_t literalLength, size_t matchLength, size_t offset, size_t previousOffset)
+{
+    enet_uint8 * token = outData ++;
+
+    if (outData > outEnd)
+      return NULL;
+
+    * token = (enet_uint8) (ENET_MIN (literalLength, ENET_LZ_RUN_MASK) << 4);
+    if (literalLength >= ENET_LZ_RUN_MASK)
+    {
+        outData = enet_lz_output_length (outData, outEnd, literalLength - ENET_LZ_RUN_MASK);
+        if (outData == NULL)
+          return NULL;
+    }
+
+    if ((size_t) (outEnd - outData) < literalLength)
+      return NULL;
+
+    memcpy (outData, literals, literalLength);
+    outData += literalLength;
+
+    if (matchLength == 0)
+      return outData;
+
+    if (outEnd - outData < 2)
+      return NULL;
+
+    if (offset == previousOffset)
+      * outData ++ = 0;
+    else
+    if (offset < ENET_LZ_SHORT_OFFSET)
+      * outData ++ = (enet_uint8) (offset << 1 | 1);
+    else
+    {
+        * outData ++ = (enet_uint8) ((offset & 0x3F) << 2 | 2);
+        * outData ++ = (enet_uint8) (offset >> 6);
+    }
+
+    matchLength -= ENET_LZ_MINIMUM_MATCH;
+    * token |= (enet_uint8) ENET_MIN (matchLength, ENET_LZ_RUN_MASK);
+    if (matchLength >= ENET_LZ_RUN_MASK)
+      outData = enet_lz_output_length (outData, outEnd, matchLength - ENET_LZ_RUN_MASK);
+
+    return outData;
+}
+
+size_t
+enet_lz_compress (void * context, const ENetBuffer * inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8 * outData, size_t outLimit)
+{
+    ENetLZ * lz = (ENetLZ *) context;
+    const enet_uint8 * input = lz -> input,
+                     * in = input,
+                     * literals = input,
+                     * inEnd;
+    enet_uint8 * outStart = outData,
+               * outEnd = & outData [outLimit];
+    size_t inLength = 0,
+           previousOffset = 0;
+
+    if (lz == NULL || inLimit > sizeof (lz -> input) || inLimit > ENET_LZ_MAXIMUM_OFFSET)
+      return 0;
+
+    while (inBufferCount -- > 0 && inLength < inLimit)
+    {
+        size_t length = ENET_MIN (inBuffers -> dataLength, inLimit - inLength);
+
+        memcpy (lz -> input + inLength, inBuffers -> data, length);
+        inLength += length;
+
+        ++ inBuffers;
+    }
+
+    inEnd = & input [inLength];
+
+    while (in + ENET_LZ_MINIMUM_MATCH <= inEnd)
+    {
+        enet_uint32 hash = enet_lz_hash (in);
+        const enet_uint8 * candidate = & input [lz -> positions [hash]],
+                         * matchEnd,
+                         * reference;
+
+        lz -> positions [hash] = (enet_uint16) (in - input);
+
+        /* the previous offset is the cheapest to encode, so it wins whenever it matches at all */
+        if (previousOffset > 0 && (size_t) (in - input) >= previousOffset && memcmp (in - previousOffset, in, ENET_LZ_MINIMUM_MATCH) == 0)
+          candidate = in - previousOffset;
+        else
+        if (candidate >= in || memcmp (candidate, in, ENET_LZ_MINIMUM_MATCH) != 0)
+        {
+            ++ in;
+            continue;
+        }
+
+        matchEnd = in + ENET_LZ_MINIMUM_MATCH;
+        reference = candidate + ENET_LZ_MINIMUM_MATCH;
+        while (matchEnd < inEnd && * matchEnd == * reference)
+        {
+            ++ matchEnd;
+            ++ reference;
+        }
+
+        outData = enet_lz_output_sequence (outData, outEnd, literals, (size_t) (in - literals), (size_t) (matchEnd - in), (size_t) (in - candidate), previousOffset);
+        if (outData == NULL)
+          return 0;
+
+        previousOffset = (size_t) (in - candidate);
+
+        in = literals = matchEnd;
+    }
+
+    outData = enet_lz_output_sequence (outData, outEnd, literals, (size_t) (inEnd - literals), 0, 0, previousOffset);
+    if (outData == NULL)
+      return 0;
+
+    return (size_t) (outData - outStart);
+}
+
+/* Reads a length continued past a saturated nibble, returns NULL on truncated input */
+static const enet_uint8 *
+enet_lz_input_length (const enet_uint8 * inData, const enet_uint8 * inEnd, size_t * length)
+{
+    enet_uint8 extra;
+
+    do
+    {
+        if (inData >= inEnd)
+          return NULL;
+
+        extra = * inData ++;
+        * length += extra;
+    } while (extra == 255);
+
+    return inData;
+}
+
+size_t
+enet_lz_decompress (void * context, const enet_uint8 * inData, size_t inLimit, enet_uint8 * outData, size_t outLimit)
+{
+    const enet_uint8 * inEnd = & inData [inLimit];
+    enet_uint8 * outStart = outData,
+               * outEnd = & outData [outLimit];
+    size_t previousOffset = 0;
+
+    (void) context;
+
+    while (inData < inEnd)
+    {
+        enet_uint8 token = * inData ++;
+        size_t length = token >> 4,
+               offset;
+        enet_uint8 marker;
+        const enet_uint8 * reference;
+
+        if (length == ENET_LZ_RUN_MASK)
+        {
+            inData = enet_lz_input_length (inData, inEnd, & length);
+            if (inData == NULL)
+              return 0;
+        }
+
+        if ((size_t) (inEnd - inData) < length || (size_t) (outEnd - outData) < length)
+          return 0;
+
+        memcpy (outData, inData, length);
+        outData += length;
+        inData += length;
+
+        if (inData >= inEnd)
+          break;
+
+        marker = * inData ++;
+        if (marker == 0)
+          offset = previousOffset;
+        else
+        if (marker & 1)
+          offset = marker >> 1;
+        else
+        {
+            if (! (marker & 2) || inData >= inEnd)
+              return 0;
+
+            offset = (size_t) (marker >> 2) | ((size_t) * inData ++ << 6);
+        }
+
+        if (offset == 0 || offset > (size_t) (outData - outStart))
+          return 0;
+
+        previousOffset = offset;
+
+        length = token & ENET_LZ_RUN_MASK;
+        if (length == ENET_LZ_RUN_MASK)
+        {
+            inData = enet_lz_input_length (inData, inEnd, & length);
+            if (inData == NULL)
+              return 0;
+        }
+        length += ENET_LZ_MINIMUM_MATCH;
+
+        if ((size_t) (outEnd - outData) < length)
+          return 0;
+
+        /* byte by byte, the reference may overlap the bytes being written */
+        reference = outData - offset;
+        while (length -- > 0)
+          * outData ++ = * reference ++;
+    }
+
+    return (size_t) (outData - outStart);
+}
+
 /** @defgroup host ENet host functions
     @{
 */
 
+/** Sets the packet compressor the host should use to the LZ compressor, much cheaper than the range coder
+    and meant for streams of small, repetitive binary frames. Both ends of a connection need the same compressor.
+    @param host host to enable the LZ compressor for
+    @returns 0 on success, < 0 on failure
+*/
+int
+enet_host_compress_with_lz (ENetHost * host)
+{
+    ENetCompressor compressor;
+    memset (& compressor, 0, sizeof (compressor));
+    compressor.context = enet_lz_create();
+    if (compressor.context == NULL)
+      return -1;
+    compressor.compress = enet_lz_compress;
+    compressor.decompress = enet_lz_decompress;
+    compressor.destroy = enet_lz_destroy;
+    enet_host_compress (host, & compressor);
+    return 0;
+}
+
 /** Sets the packet compressor the host should use to the default range coder.
     @param host host to enable the range coder for
     @returns 0 on success, < 0 on failure
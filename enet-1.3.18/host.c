@@ -48,12 +48,55 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     }
     memset (host -> peers, 0, peerCount * sizeof (ENetPeer));
 
+    for (host -> peerBucketMask = 1; host -> peerBucketMask < peerCount; host -> peerBucketMask <<= 1);
+    host -> peerBuckets = (ENetPeer **) enet_malloc (host -> peerBucketMask * sizeof (ENetPeer *));
+    if (host -> peerBuckets == NULL)
+    {
+       enet_free (host -> peers);
+       enet_free (host);
+
+       return NULL;
+    }
+    memset (host -> peerBuckets, 0, host -> peerBucketMask * sizeof (ENetPeer *));
+    -- host -> peerBucketMask;
+
+    /* The first receive slot is packetData [0], every other batch slot gets its own MTU sized buffer */
+    host -> batchData = (enet_uint8 *) enet_malloc ((2 * ENET_SOCKET_BATCH_SIZE - 1) * ENET_PROTOCOL_MAXIMUM_MTU);
+    if (host -> batchData == NULL)
+    {
+       enet_free (host -> peerBuckets);
+       enet_free (host -> peers);
+       enet_free (host);
+
+       return NULL;
+    }
+    for (size_t i = 0; i < ENET_SOCKET_BATCH_SIZE; ++ i)
+    {
+       host -> receiveBatch [i].data = i == 0 ? host -> packetData [0] : & host -> batchData [(i - 1) * ENET_PROTOCOL_MAXIMUM_MTU];
+       host -> receiveBatch [i].dataLength = ENET_PROTOCOL_MAXIMUM_MTU;
+       host -> sendBatch [i].data = & host -> batchData [(ENET_SOCKET_BATCH_SIZE - 1 + i) * ENET_PROTOCOL_MAXIMUM_MTU];
+       host -> sendBatch [i].dataLength = 0;
+    }
+
     host -> socket = enet_socket_create (ENET_SOCKET_TYPE_DATAGRAM);
     if (host -> socket == ENET_SOCKET_NULL || (address != NULL && enet_socket_bind (host -> socket, address) < 0))
     {
        if (host -> socket != ENET_SOCKET_NULL)
          enet_socket_destroy (host -> socket);
 
+       enet_free (host -> batchData);
+       enet_free (host -> peerBuckets);
+       enet_free (host -> peers);
+       enet_free (host);
+
+       return NULL;
+    }
+
+    if (enet_host_wait_create (host) < 0)
+    {
+       enet_socket_destroy (host -> socket);
+       enet_free (host -> batchData);
+       enet_free (host -> peerBuckets);
        enet_free (host -> peers);
        enet_free (host);
 
@@ -95,6 +138,7 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     host -> totalSentData = 0;
     host -> totalSentPackets = 0;
     host -> totalReceivedData = 0;
+    host -> totalChecksumFailures = 0;
     host -> totalReceivedPackets = 0;
     host -> totalQueued = 0;
 
@@ -112,6 +156,7 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     host -> intercept = NULL;
 
     enet_list_clear (& host -> dispatchQueue);
+    enet_list_clear (& host -> activePeers);
 
     for (currentPeer = host -> peers;
          currentPeer < & host -> peers [host -> peerCount];
@@ -145,6 +190,7 @@ enet_host_destroy (ENetHost * host)
     if (host == NULL)
       return;
 
+    enet_host_wait_destroy (host);
     enet_socket_destroy (host -> socket);
 
     for (currentPeer = host -> peers;
@@ -157,10 +203,100 @@ enet_host_destroy (ENetHost * host)
     if (host -> compressor.context != NULL && host -> compressor.destroy)
       (* host -> compressor.destroy) (host -> compressor.context);
 
+    enet_free (host -> batchData);
+    enet_free (host -> peerBuckets);
     enet_free (host -> peers);
     enet_free (host);
 }
 
+/** Returns the head of the address hash chain address belongs to */
+ENetPeer **
+enet_host_peer_bucket (ENetHost * host, const ENetAddress * address)
+{
+    enet_uint32 hash = (address -> host ^ ((enet_uint32) address -> port << 16 | address -> port)) * 0x9E3779B1U;
+
+    return & host -> peerBuckets [(hash ^ (hash >> 16)) & host -> peerBucketMask];
+}
+
+/** Looks up a peer by address.
+    @param host host to search
+    @param address address the peer sends from
+    @returns the connected peer at address if there is one, otherwise any other peer at it that isn't disconnected, or NULL
+*/
+ENetPeer *
+enet_host_find_peer (ENetHost * host, const ENetAddress * address)
+{
+    ENetPeer * peer, * found = NULL;
+
+    for (peer = * enet_host_peer_bucket (host, address); peer != NULL; peer = peer -> nextInBucket)
+    {
+       if (peer -> address.host != address -> host || peer -> address.port != address -> port)
+         continue;
+
+       if (peer -> state == ENET_PEER_STATE_CONNECTED)
+         return peer;
+
+       if (found == NULL)
+         found = peer;
+    }
+
+    return found;
+}
+
+/** Adds a peer leaving the disconnected state to host -> activePeers and the address hash */
+void
+enet_host_activate_peer (ENetHost * host, ENetPeer * peer)
+{
+    ENetPeer ** bucket = enet_host_peer_bucket (host, & peer -> address);
+
+    enet_list_insert (enet_list_end (& host -> activePeers), & peer -> activeList);
+
+    peer -> nextInBucket = * bucket;
+    * bucket = peer;
+}
+
+static void
+enet_host_unhash_peer (ENetHost * host, ENetPeer * peer)
+{
+    ENetPeer ** link;
+
+    for (link = enet_host_peer_bucket (host, & peer -> address); * link != NULL; link = & (* link) -> nextInBucket)
+    {
+       if (* link == peer)
+       {
+          * link = peer -> nextInBucket;
+          break;
+       }
+    }
+
+    peer -> nextInBucket = NULL;
+}
+
+/** Removes a peer from host -> activePeers and the address hash when it is reset */
+void
+enet_host_deactivate_peer (ENetHost * host, ENetPeer * peer)
+{
+    enet_list_remove (& peer -> activeList);
+    peer -> activeList.next = NULL;
+
+    enet_host_unhash_peer (host, peer);
+}
+
+/** Moves an active peer to the hash bucket of its new address, after a NAT rebinding for example */
+void
+enet_host_change_peer_address (ENetHost * host, ENetPeer * peer, const ENetAddress * address)
+{
+    ENetPeer ** bucket;
+
+    enet_host_unhash_peer (host, peer);
+
+    peer -> address = * address;
+
+    bucket = enet_host_peer_bucket (host, & peer -> address);
+    peer -> nextInBucket = * bucket;
+    * bucket = peer;
+}
+
 enet_uint32
 enet_host_random (ENetHost * host)
 {
@@ -210,6 +346,7 @@ enet_host_connect (ENetHost * host, const ENetAddress * address, size_t channelC
     currentPeer -> channelCount = channelCount;
     currentPeer -> state = ENET_PEER_STATE_CONNECTING;
     currentPeer -> address = * address;
+    enet_host_activate_peer (host, currentPeer);
     currentPeer -> connectID = enet_host_random (host);
     currentPeer -> mtu = host -> mtu;
 
@@ -272,11 +409,14 @@ void
 enet_host_broadcast (ENetHost * host, enet_uint8 channelID, ENetPacket * packet)
 {
     ENetPeer * currentPeer;
+    ENetListIterator currentNode;
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    for (currentNode = enet_list_begin (& host -> activePeers);
+         currentNode != enet_list_end (& host -> activePeers);
+         currentNode = enet_list_next (currentNode))
     {
+       currentPeer = ENET_ACTIVE_PEER (currentNode);
+
        if (currentPeer -> state != ENET_PEER_STATE_CONNECTED)
          continue;
 
@@ -347,6 +487,7 @@ enet_host_bandwidth_throttle (ENetHost * host)
            bandwidthLimit = 0;
     int needsAdjustment = host -> bandwidthLimitedPeers > 0 ? 1 : 0;
     ENetPeer * peer;
+    ENetListIterator currentNode;
     ENetProtocol command;
 
     if (elapsedTime < ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL)
@@ -362,10 +503,12 @@ enet_host_bandwidth_throttle (ENetHost * host)
         dataTotal = 0;
         bandwidth = (host -> outgoingBandwidth * elapsedTime) / 1000;
 
-        for (peer = host -> peers;
-             peer < & host -> peers [host -> peerCount];
-            ++ peer)
+        for (currentNode = enet_list_begin (& host -> activePeers);
+             currentNode != enet_list_end (& host -> activePeers);
+             currentNode = enet_list_next (currentNode))
         {
+            peer = ENET_ACTIVE_PEER (currentNode);
+
             if (peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER)
               continue;
 
@@ -382,11 +525,13 @@ enet_host_bandwidth_throttle (ENetHost * host)
         else
           throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
 
-        for (peer = host -> peers;
-             peer < & host -> peers [host -> peerCount];
-             ++ peer)
+        for (currentNode = enet_list_begin (& host -> activePeers);
+             currentNode != enet_list_end (& host -> activePeers);
+             currentNode = enet_list_next (currentNode))
         {
             enet_uint32 peerBandwidth;
+
+            peer = ENET_ACTIVE_PEER (currentNode);
             
             if ((peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER) ||
                 peer -> incomingBandwidth == 0 ||
@@ -425,10 +570,12 @@ enet_host_bandwidth_throttle (ENetHost * host)
         else
           throttle = (bandwidth * ENET_PEER_PACKET_THROTTLE_SCALE) / dataTotal;
 
-        for (peer = host -> peers;
-             peer < & host -> peers [host -> peerCount];
-             ++ peer)
+        for (currentNode = enet_list_begin (& host -> activePeers);
+             currentNode != enet_list_end (& host -> activePeers);
+             currentNode = enet_list_next (currentNode))
         {
+            peer = ENET_ACTIVE_PEER (currentNode);
+
             if ((peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER) ||
                 peer -> outgoingBandwidthThrottleEpoch == timeCurrent)
               continue;
@@ -459,10 +606,12 @@ enet_host_bandwidth_throttle (ENetHost * host)
            needsAdjustment = 0;
            bandwidthLimit = bandwidth / peersRemaining;
 
-           for (peer = host -> peers;
-                peer < & host -> peers [host -> peerCount];
-                ++ peer)
+           for (currentNode = enet_list_begin (& host -> activePeers);
+                currentNode != enet_list_end (& host -> activePeers);
+                currentNode = enet_list_next (currentNode))
            {
+               peer = ENET_ACTIVE_PEER (currentNode);
+
                if ((peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER) ||
                    peer -> incomingBandwidthThrottleEpoch == timeCurrent)
                  continue;
@@ -479,10 +628,12 @@ enet_host_bandwidth_throttle (ENetHost * host)
            }
        }
 
-       for (peer = host -> peers;
-            peer < & host -> peers [host -> peerCount];
-            ++ peer)
+       for (currentNode = enet_list_begin (& host -> activePeers);
+            currentNode != enet_list_end (& host -> activePeers);
+            currentNode = enet_list_next (currentNode))
        {
+           peer = ENET_ACTIVE_PEER (currentNode);
+
            if (peer -> state != ENET_PEER_STATE_CONNECTED && peer -> state != ENET_PEER_STATE_DISCONNECT_LATER)
              continue;
 
@@ -10,6 +10,7 @@ extern "C"
 {
 #endif
 
+#include <stddef.h>
 #include <stdlib.h>
 
 #ifdef _WIN32
@@ -174,6 +175,7 @@ typedef struct _ENetOutgoingCommand
    enet_uint32  fragmentOffset;
    enet_uint16  fragmentLength;
    enet_uint16  sendAttempts;
+   enet_uint32  sentTimeMicros;              /**< enet_time_get_micros () when last sent */
    ENetProtocol command;
    ENetPacket * packet;
 } ENetOutgoingCommand;
@@ -208,6 +210,11 @@ typedef enum _ENetPeerState
 #define ENET_BUFFER_MAXIMUM (1 + 2 * ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS)
 #endif
 
+/** Datagrams moved per batched socket call (recvmmsg/sendmmsg where available) */
+#ifndef ENET_SOCKET_BATCH_SIZE
+#define ENET_SOCKET_BATCH_SIZE 16
+#endif
+
 enum
 {
    ENET_HOST_RECEIVE_BUFFER_SIZE          = 256 * 1024,
@@ -265,6 +272,8 @@ typedef enum _ENetPeerFlag
 typedef struct _ENetPeer
 { 
    ENetListNode  dispatchList;
+   ENetListNode  activeList;                   /**< node in host->activePeers while the peer isn't disconnected, next is NULL otherwise */
+   struct _ENetPeer * nextInBucket;            /**< next peer in the same host->peerBuckets chain */
    struct _ENetHost * host;
    enet_uint16   outgoingPeerID;
    enet_uint16   incomingPeerID;
@@ -324,8 +333,16 @@ typedef struct _ENetPeer
    enet_uint32   unsequencedWindow [ENET_PEER_UNSEQUENCED_WINDOW_SIZE / 32]; 
    enet_uint32   eventData;
    size_t        totalWaitingData;
+   enet_uint32   roundTripTimeMicros;          /**< smoothed RTT in microseconds, from reliable commands acknowledged after their first send */
+   enet_uint32   roundTripTimeVarianceMicros;  /**< mean deviation of the RTT samples from roundTripTimeMicros */
+   enet_uint32   roundTripJitterMicros;        /**< smoothed difference between consecutive RTT samples */
+   enet_uint32   lastRoundTripTimeMicros;      /**< latest RTT sample in microseconds */
+   enet_uint32   roundTripSamples;             /**< RTT samples taken since the peer was reset */
 } ENetPeer;
 
+/** Peer owning a node of ENetHost::activePeers */
+#define ENET_ACTIVE_PEER(node) ((ENetPeer *) ((enet_uint8 *) (node) - offsetof (ENetPeer, activeList)))
+
 /** An ENet packet compressor for compressing UDP packets before socket sends or receives.
  */
 typedef struct _ENetCompressor
@@ -358,6 +375,7 @@ typedef int (ENET_CALLBACK * ENetInterceptCallback) (struct _ENetHost * host, st
     @sa enet_host_broadcast()
     @sa enet_host_compress()
     @sa enet_host_compress_with_range_coder()
+    @sa enet_host_compress_with_lz()
     @sa enet_host_channel_limit()
     @sa enet_host_bandwidth_limit()
     @sa enet_host_bandwidth_throttle()
@@ -377,6 +395,9 @@ typedef struct _ENetHost
    size_t               channelLimit;                /**< maximum number of channels allowed for connected peers */
    enet_uint32          serviceTime;
    ENetList             dispatchQueue;
+   ENetList             activePeers;                 /**< peers that aren't disconnected, so servicing doesn't walk every allocated peer */
+   ENetPeer **          peerBuckets;                 /**< active peers hashed by address, chained through nextInBucket */
+   size_t               peerBucketMask;
    enet_uint32          totalQueued;
    size_t               packetSize;
    enet_uint16          headerFlags;
@@ -394,12 +415,23 @@ typedef struct _ENetHost
    enet_uint32          totalSentPackets;            /**< total UDP packets sent, user should reset to 0 as needed to prevent overflow */
    enet_uint32          totalReceivedData;           /**< total data received, user should reset to 0 as needed to prevent overflow */
    enet_uint32          totalReceivedPackets;        /**< total UDP packets received, user should reset to 0 as needed to prevent overflow */
+   enet_uint32          totalChecksumFailures;       /**< total UDP packets dropped because their checksum didn't match */
    ENetInterceptCallback intercept;                  /**< callback the user can set to intercept received raw UDP packets */
    size_t               connectedPeers;
    size_t               bandwidthLimitedPeers;
    size_t               duplicatePeers;              /**< optional number of allowed peers from duplicate IPs, defaults to ENET_PROTOCOL_MAXIMUM_PEER_ID */
    size_t               maximumPacketSize;           /**< the maximum allowable packet size that may be sent or received on a peer */
    size_t               maximumWaitingData;          /**< the maximum aggregate amount of buffer space a peer may use waiting for packets to be delivered */
+   enet_uint8 *         batchData;                   /**< storage for the receive and send batches besides packetData [0] */
+   ENetBuffer           receiveBatch [ENET_SOCKET_BATCH_SIZE];
+   ENetAddress          receiveBatchAddresses [ENET_SOCKET_BATCH_SIZE];
+   size_t               receiveBatchLengths [ENET_SOCKET_BATCH_SIZE];
+   size_t               receiveBatchCount;           /**< datagrams read by the last batched receive */
+   size_t               receiveBatchIndex;           /**< next of those datagrams to handle */
+   ENetBuffer           sendBatch [ENET_SOCKET_BATCH_SIZE];
+   ENetAddress          sendBatchAddresses [ENET_SOCKET_BATCH_SIZE];
+   size_t               sendBatchCount;              /**< datagrams waiting to be sent with one batched send */
+   int                  waitDescriptor;              /**< epoll instance watching socket when built with HAS_EPOLL, otherwise -1 */
 } ENetHost;
 
 /**
@@ -484,12 +516,17 @@ ENET_API ENetVersion enet_linked_version (void);
 /** @defgroup private ENet private implementation functions */
 
 /**
-  Returns the wall-time in milliseconds.  Its initial value is unspecified
+  Returns the monotonic time in milliseconds.  Its initial value is unspecified
   unless otherwise set.
   */
 ENET_API enet_uint32 enet_time_get (void);
 /**
-  Sets the current wall-time in milliseconds.
+  Returns the monotonic time in microseconds, wrapping around every 71 minutes.
+  Not affected by enet_time_set, only meant for measuring intervals.
+  */
+ENET_API enet_uint32 enet_time_get_micros (void);
+/**
+  Sets the current monotonic time in milliseconds.
   */
 ENET_API void enet_time_set (enet_uint32);
 
@@ -504,7 +541,12 @@ ENET_API ENetSocket enet_socket_accept (ENetSocket, ENetAddress *);
 ENET_API int        enet_socket_connect (ENetSocket, const ENetAddress *);
 ENET_API int        enet_socket_send (ENetSocket, const ENetAddress *, const ENetBuffer *, size_t);
 ENET_API int        enet_socket_receive (ENetSocket, ENetAddress *, ENetBuffer *, size_t);
+ENET_API int        enet_socket_send_batch (ENetSocket, const ENetAddress *, const ENetBuffer *, size_t);
+ENET_API int        enet_socket_receive_batch (ENetSocket, ENetAddress *, ENetBuffer *, size_t *, size_t);
 ENET_API int        enet_socket_wait (ENetSocket, enet_uint32 *, enet_uint32);
+ENET_API int        enet_host_wait_create (ENetHost *);
+ENET_API void       enet_host_wait_destroy (ENetHost *);
+ENET_API int        enet_host_wait (ENetHost *, enet_uint32 *, enet_uint32);
 ENET_API int        enet_socket_set_option (ENetSocket, ENetSocketOption, int);
 ENET_API int        enet_socket_get_option (ENetSocket, ENetSocketOption, int *);
 ENET_API int        enet_socket_shutdown (ENetSocket, ENetSocketShutdown);
@@ -563,6 +605,11 @@ ENET_API ENetPacket * enet_packet_create (const void *, size_t, enet_uint32);
 ENET_API void         enet_packet_destroy (ENetPacket *);
 ENET_API int          enet_packet_resize  (ENetPacket *, size_t);
 ENET_API enet_uint32  enet_crc32 (const ENetBuffer *, size_t);
+/** Returns the name of the CRC32 implementation enet_crc32 uses on this machine
+    ("table", "slice-by-8" or "armv8 crc32"), picked by enet_initialize.
+*/
+ENET_API const char * enet_crc32_implementation (void);
+extern   void         enet_crc32_initialize (void);
                 
 ENET_API ENetHost * enet_host_create (const ENetAddress *, size_t, size_t, enet_uint32, enet_uint32);
 ENET_API void       enet_host_destroy (ENetHost *);
@@ -573,9 +620,15 @@ ENET_API void       enet_host_flush (ENetHost *);
 ENET_API void       enet_host_broadcast (ENetHost *, enet_uint8, ENetPacket *);
 ENET_API void       enet_host_compress (ENetHost *, const ENetCompressor *);
 ENET_API int        enet_host_compress_with_range_coder (ENetHost * host);
+ENET_API int        enet_host_compress_with_lz (ENetHost * host);
 ENET_API void       enet_host_channel_limit (ENetHost *, size_t);
 ENET_API void       enet_host_bandwidth_limit (ENetHost *, enet_uint32, enet_uint32);
 extern   void       enet_host_bandwidth_throttle (ENetHost *);
+ENET_API ENetPeer * enet_host_find_peer (ENetHost *, const ENetAddress *);
+extern   ENetPeer ** enet_host_peer_bucket (ENetHost *, const ENetAddress *);
+extern   void       enet_host_activate_peer (ENetHost *, ENetPeer *);
+extern   void       enet_host_deactivate_peer (ENetHost *, ENetPeer *);
+extern   void       enet_host_change_peer_address (ENetHost *, ENetPeer *, const ENetAddress *);
 extern  enet_uint32 enet_host_random_seed (void);
 extern  enet_uint32 enet_host_random (ENetHost *);
 
@@ -605,6 +658,11 @@ ENET_API void * enet_range_coder_create (void);
 ENET_API void   enet_range_coder_destroy (void *);
 ENET_API size_t enet_range_coder_compress (void *, const ENetBuffer *, size_t, size_t, enet_uint8 *, size_t);
 ENET_API size_t enet_range_coder_decompress (void *, const enet_uint8 *, size_t, enet_uint8 *, size_t);
+
+ENET_API void * enet_lz_create (void);
+ENET_API void   enet_lz_destroy (void *);
+ENET_API size_t enet_lz_compress (void *, const ENetBuffer *, size_t, size_t, enet_uint8 *, size_t);
+ENET_API size_t enet_lz_decompress (void *, const enet_uint8 *, size_t, enet_uint8 *, size_t);
    
 extern size_t enet_protocol_command_size (enet_uint8);
 
@@ -6,6 +6,12 @@
 #define ENET_BUILDING_LIB 1
 #include "enet/enet.h"
 
+#if defined (__aarch64__) && defined (__linux__) && defined (__GNUC__) && ! defined (__clang__)
+#define HAS_ARM_CRC32 1
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
 /** @defgroup Packet ENet packet functions 
     @{ 
 */
@@ -134,6 +140,117 @@ static const enet_uint32 crcTable [256] =
     0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
+/* crcTable extended for slice-by-8, crcSlices [k] [i] is the CRC of byte i followed by k zero bytes */
+static enet_uint32 crcSlices [8] [256];
+
+static enet_uint32
+enet_crc32_update_bytes (enet_uint32 crc, const enet_uint8 * data, size_t length)
+{
+    while (length -- > 0)
+      crc = (crc >> 8) ^ crcTable [(crc & 0xFF) ^ *data++];
+
+    return crc;
+}
+
+static enet_uint32
+enet_crc32_update_slices (enet_uint32 crc, const enet_uint8 * data, size_t length)
+{
+    while (length >= 8)
+    {
+        crc ^= (enet_uint32) data [0] | ((enet_uint32) data [1] << 8) | ((enet_uint32) data [2] << 16) | ((enet_uint32) data [3] << 24);
+        crc = crcSlices [7] [crc & 0xFF] ^ crcSlices [6] [(crc >> 8) & 0xFF] ^
+              crcSlices [5] [(crc >> 16) & 0xFF] ^ crcSlices [4] [crc >> 24] ^
+              crcSlices [3] [data [4]] ^ crcSlices [2] [data [5]] ^
+              crcSlices [1] [data [6]] ^ crcSlices [0] [data [7]];
+
+        data += 8;
+        length -= 8;
+    }
+
+    return enet_crc32_update_bytes (crc, data, length);
+}
+
+#ifdef HAS_ARM_CRC32
+#pragma GCC push_options
+#pragma GCC target ("+crc")
+#include <arm_acle.h>
+
+/* ARMv8 CRC32 instructions use the same polynomial and bit order as crcTable */
+static enet_uint32
+enet_crc32_update_arm (enet_uint32 crc, const enet_uint8 * data, size_t length)
+{
+    while (length >= 8)
+    {
+        unsigned long long word;
+
+        memcpy (& word, data, 8);
+        crc = __crc32d (crc, word);
+
+        data += 8;
+        length -= 8;
+    }
+
+    if (length >= 4)
+    {
+        enet_uint32 word;
+
+        memcpy (& word, data, 4);
+        crc = __crc32w (crc, word);
+
+        data += 4;
+        length -= 4;
+    }
+
+    while (length -- > 0)
+      crc = __crc32b (crc, * data ++);
+
+    return crc;
+}
+
+#pragma GCC pop_options
+#endif
+
+/* Byte at a time until enet_crc32_initialize picks the fastest implementation */
+static enet_uint32 (* crcUpdate) (enet_uint32, const enet_uint8 *, size_t) = enet_crc32_update_bytes;
+static const char * crcImplementation = "table";
+
+void
+enet_crc32_initialize (void)
+{
+    int slice, byte;
+
+#ifdef HAS_ARM_CRC32
+    if (getauxval (AT_HWCAP) & HWCAP_CRC32)
+    {
+       crcUpdate = enet_crc32_update_arm;
+       crcImplementation = "armv8 crc32";
+       return;
+    }
+#endif
+
+    for (byte = 0; byte < 256; ++ byte)
+      crcSlices [0] [byte] = crcTable [byte];
+
+    for (slice = 1; slice < 8; ++ slice)
+    {
+       for (byte = 0; byte < 256; ++ byte)
+       {
+          enet_uint32 previous = crcSlices [slice - 1] [byte];
+
+          crcSlices [slice] [byte] = (previous >> 8) ^ crcTable [previous & 0xFF];
+       }
+    }
+
+    crcUpdate = enet_crc32_update_slices;
+    crcImplementation = "slice-by-8";
+}
+
+const char *
+enet_crc32_implementation (void)
+{
+    return crcImplementation;
+}
+
 enet_uint32
 enet_crc32 (const ENetBuffer * buffers, size_t bufferCount)
 {
@@ -141,13 +258,7 @@ enet_crc32 (const ENetBuffer * buffers, size_t bufferCount)
 
     while (bufferCount -- > 0)
     {
-        const enet_uint8 * data = (const enet_uint8 *) buffers -> data,
-                         * dataEnd = & data [buffers -> dataLength];
-
-        while (data < dataEnd)
-        {
-            crc = (crc >> 8) ^ crcTable [(crc & 0xFF) ^ *data++];
-        }
+        crc = crcUpdate (crc, (const enet_uint8 *) buffers -> data, buffers -> dataLength);
 
         ++ buffers;
     }
@@ -382,6 +382,9 @@ void
 enet_peer_reset (ENetPeer * peer)
 {
     enet_peer_on_disconnect (peer);
+
+    if (peer -> activeList.next != NULL)
+      enet_host_deactivate_peer (peer -> host, peer);
         
     peer -> outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
     peer -> connectID = 0;
@@ -420,6 +423,11 @@ enet_peer_reset (ENetPeer * peer)
     peer -> highestRoundTripTimeVariance = 0;
     peer -> roundTripTime = ENET_PEER_DEFAULT_ROUND_TRIP_TIME;
     peer -> roundTripTimeVariance = 0;
+    peer -> roundTripTimeMicros = 0;
+    peer -> roundTripTimeVarianceMicros = 0;
+    peer -> roundTripJitterMicros = 0;
+    peer -> lastRoundTripTimeMicros = 0;
+    peer -> roundTripSamples = 0;
     peer -> mtu = peer -> host -> mtu;
     peer -> reliableDataInTransit = 0;
     peer -> outgoingReliableSequenceNumber = 0;
@@ -676,6 +684,7 @@ enet_peer_setup_outgoing_command (ENetPeer * peer, ENetOutgoingCommand * outgoin
     }
 
     outgoingCommand -> sendAttempts = 0;
+    outgoingCommand -> sentTimeMicros = 0;
     outgoingCommand -> sentTime = 0;
     outgoingCommand -> roundTripTimeout = 0;
     outgoingCommand -> command.header.reliableSequenceNumber = ENET_HOST_TO_NET_16 (outgoingCommand -> reliableSequenceNumber);
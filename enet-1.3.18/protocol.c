@@ -217,8 +217,11 @@ enet_protocol_find_sent_reliable_command (ENetList * list, enet_uint16 reliableS
     return NULL;
 }
 
+/** Removes an acknowledged reliable command. If roundTripMicros isn't NULL it is set to the command's round trip
+    time in microseconds, or 0 if the command was resent (Karn's algorithm, the acknowledgement could be for any send).
+*/
 static ENetProtocolCommand
-enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID)
+enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliableSequenceNumber, enet_uint8 channelID, enet_uint32 * roundTripMicros)
 {
     ENetOutgoingCommand * outgoingCommand = NULL;
     ENetListIterator currentCommand;
@@ -261,6 +264,9 @@ enet_protocol_remove_sent_reliable_command (ENetPeer * peer, enet_uint16 reliabl
     }
 
     commandNumber = (ENetProtocolCommand) (outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_MASK);
+
+    if (roundTripMicros != NULL)
+      * roundTripMicros = wasSent && outgoingCommand -> sendAttempts == 1 ? ENET_MAX (enet_time_get_micros () - outgoingCommand -> sentTimeMicros, 1) : 0;
     
     enet_list_remove (& outgoingCommand -> outgoingCommandList);
 
@@ -299,6 +305,7 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
     ENetChannel * channel;
     size_t channelCount, duplicatePeers = 0;
     ENetPeer * currentPeer, * peer = NULL;
+    ENetListIterator currentNode;
     ENetProtocol verifyCommand;
 
     channelCount = ENET_NET_TO_HOST_32 (command -> connect.channelCount);
@@ -307,28 +314,48 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
         channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
       return NULL;
 
+    /* A resent connect from a peer we already know */
+    for (currentPeer = * enet_host_peer_bucket (host, & host -> receivedAddress);
+         currentPeer != NULL;
+         currentPeer = currentPeer -> nextInBucket)
+    {
+        if (currentPeer -> state != ENET_PEER_STATE_CONNECTING &&
+            currentPeer -> address.host == host -> receivedAddress.host &&
+            currentPeer -> address.port == host -> receivedAddress.port &&
+            currentPeer -> connectID == command -> connect.connectID)
+          return NULL;
+    }
+
+    /* Peers from the same IP only need counting when the host limits them */
+    if (host -> duplicatePeers < ENET_PROTOCOL_MAXIMUM_PEER_ID)
+    {
+        for (currentNode = enet_list_begin (& host -> activePeers);
+             currentNode != enet_list_end (& host -> activePeers);
+             currentNode = enet_list_next (currentNode))
+        {
+            currentPeer = ENET_ACTIVE_PEER (currentNode);
+
+            if (currentPeer -> state != ENET_PEER_STATE_CONNECTING &&
+                currentPeer -> address.host == host -> receivedAddress.host)
+              ++ duplicatePeers;
+        }
+
+        if (duplicatePeers >= host -> duplicatePeers)
+          return NULL;
+    }
+
     for (currentPeer = host -> peers;
          currentPeer < & host -> peers [host -> peerCount];
          ++ currentPeer)
     {
         if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED)
         {
-            if (peer == NULL)
-              peer = currentPeer;
-        }
-        else 
-        if (currentPeer -> state != ENET_PEER_STATE_CONNECTING &&
-            currentPeer -> address.host == host -> receivedAddress.host)
-        {
-            if (currentPeer -> address.port == host -> receivedAddress.port &&
-                currentPeer -> connectID == command -> connect.connectID)
-              return NULL;
-
-            ++ duplicatePeers;
+            peer = currentPeer;
+            break;
         }
     }
 
-    if (peer == NULL || duplicatePeers >= host -> duplicatePeers)
+    if (peer == NULL)
       return NULL;
 
     if (channelCount > host -> channelLimit)
@@ -340,6 +367,7 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
     peer -> state = ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
     peer -> connectID = command -> connect.connectID;
     peer -> address = host -> receivedAddress;
+    enet_host_activate_peer (host, peer);
     peer -> mtu = host -> mtu;
     peer -> outgoingPeerID = ENET_NET_TO_HOST_16 (command -> connect.outgoingPeerID);
     peer -> incomingBandwidth = ENET_NET_TO_HOST_32 (command -> connect.incomingBandwidth);
@@ -847,10 +875,42 @@ enet_protocol_handle_disconnect (ENetHost * host, ENetPeer * peer, const ENetPro
     return 0;
 }
 
+/** Microsecond counterpart of the millisecond round trip estimate, smoothed the same way (RFC 6298 gains).
+    The jitter is the smoothed difference between consecutive samples (RFC 3550 gain).
+*/
+static void
+enet_protocol_update_round_trip_micros (ENetPeer * peer, enet_uint32 sample)
+{
+    if (peer -> roundTripSamples == 0)
+    {
+       peer -> roundTripTimeMicros = sample;
+       peer -> roundTripTimeVarianceMicros = sample / 2;
+       peer -> roundTripJitterMicros = 0;
+    }
+    else
+    {
+       enet_uint32 deviation = ENET_DIFFERENCE (sample, peer -> roundTripTimeMicros),
+                   change = ENET_DIFFERENCE (sample, peer -> lastRoundTripTimeMicros);
+
+       peer -> roundTripTimeVarianceMicros = peer -> roundTripTimeVarianceMicros - peer -> roundTripTimeVarianceMicros / 4 + deviation / 4;
+
+       if (sample >= peer -> roundTripTimeMicros)
+         peer -> roundTripTimeMicros += (sample - peer -> roundTripTimeMicros) / 8;
+       else
+         peer -> roundTripTimeMicros -= (peer -> roundTripTimeMicros - sample) / 8;
+
+       peer -> roundTripJitterMicros = peer -> roundTripJitterMicros - peer -> roundTripJitterMicros / 16 + change / 16;
+    }
+
+    peer -> lastRoundTripTimeMicros = sample;
+    ++ peer -> roundTripSamples;
+}
+
 static int
 enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer * peer, const ENetProtocol * command)
 {
     enet_uint32 roundTripTime,
+           roundTripMicros,
            receivedSentTime,
            receivedReliableSequenceNumber;
     ENetProtocolCommand commandNumber;
@@ -915,7 +975,10 @@ enet_protocol_handle_acknowledge (ENetHost * host, ENetEvent * event, ENetPeer *
 
     receivedReliableSequenceNumber = ENET_NET_TO_HOST_16 (command -> acknowledge.receivedReliableSequenceNumber);
 
-    commandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID);
+    commandNumber = enet_protocol_remove_sent_reliable_command (peer, receivedReliableSequenceNumber, command -> header.channelID, & roundTripMicros);
+
+    if (roundTripMicros > 0)
+      enet_protocol_update_round_trip_micros (peer, roundTripMicros);
 
     switch (peer -> state)
     {
@@ -969,7 +1032,7 @@ enet_protocol_handle_verify_connect (ENetHost * host, ENetEvent * event, ENetPee
         return -1;
     }
 
-    enet_protocol_remove_sent_reliable_command (peer, 1, 0xFF);
+    enet_protocol_remove_sent_reliable_command (peer, 1, 0xFF, NULL);
     
     if (channelCount < peer -> channelCount)
       peer -> channelCount = channelCount;
@@ -1085,13 +1148,18 @@ enet_protocol_handle_incoming_commands (ENetHost * host, ENetEvent * event)
         buffer.dataLength = host -> receivedDataLength;
 
         if (host -> checksum (& buffer, 1) != desiredChecksum)
-          return 0;
+        {
+           ++ host -> totalChecksumFailures;
+
+           return 0;
+        }
     }
        
     if (peer != NULL)
     {
-       peer -> address.host = host -> receivedAddress.host;
-       peer -> address.port = host -> receivedAddress.port;
+       if (peer -> address.host != host -> receivedAddress.host ||
+           peer -> address.port != host -> receivedAddress.port)
+         enet_host_change_peer_address (host, peer, & host -> receivedAddress);
        peer -> incomingDataTotal += host -> receivedDataLength;
     }
     
@@ -1235,27 +1303,37 @@ enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
 
     for (packets = 0; packets < 256; ++ packets)
     {
-       int receivedLength;
-       ENetBuffer buffer;
+       size_t receivedLength, datagram;
 
-       buffer.data = host -> packetData [0];
-       buffer.dataLength = sizeof (host -> packetData [0]);
+       /* Read as many waiting datagrams as fit in one system call, then handle them one at a time.
+          Any left when an event is returned are handled first on the next call. */
+       if (host -> receiveBatchIndex >= host -> receiveBatchCount)
+       {
+          int received = enet_socket_receive_batch (host -> socket,
+                                                    host -> receiveBatchAddresses,
+                                                    host -> receiveBatch,
+                                                    host -> receiveBatchLengths,
+                                                    ENET_SOCKET_BATCH_SIZE);
 
-       receivedLength = enet_socket_receive (host -> socket,
-                                             & host -> receivedAddress,
-                                             & buffer,
-                                             1);
+          if (received < 0)
+            return -1;
 
-       if (receivedLength == -2)
-         continue;
+          if (received == 0)
+            return 0;
 
-       if (receivedLength < 0)
-         return -1;
+          host -> receiveBatchCount = received;
+          host -> receiveBatchIndex = 0;
+       }
 
+       datagram = host -> receiveBatchIndex ++;
+       receivedLength = host -> receiveBatchLengths [datagram];
+
+       /* Truncated */
        if (receivedLength == 0)
-         return 0;
+         continue;
 
-       host -> receivedData = host -> packetData [0];
+       host -> receivedAddress = host -> receiveBatchAddresses [datagram];
+       host -> receivedData = (enet_uint8 *) host -> receiveBatch [datagram].data;
        host -> receivedDataLength = receivedLength;
       
        host -> totalReceivedData += receivedLength;
@@ -1512,6 +1590,7 @@ enet_protocol_check_outgoing_commands (ENetHost * host, ENetPeer * peer, ENetLis
                             enet_list_remove (& outgoingCommand -> outgoingCommandList));
 
           outgoingCommand -> sentTime = host -> serviceTime;
+          outgoingCommand -> sentTimeMicros = enet_time_get_micros ();
 
           host -> headerFlags |= ENET_PROTOCOL_HEADER_FLAG_SENT_TIME;
 
@@ -1596,8 +1675,58 @@ enet_protocol_check_outgoing_commands (ENetHost * host, ENetPeer * peer, ENetLis
     return canPing;
 }
 
+/** Sends every datagram queued by enet_protocol_queue_datagram with one batched send */
 static int
-enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
+enet_protocol_flush_send_batch (ENetHost * host)
+{
+    int sent, datagram;
+
+    if (host -> sendBatchCount == 0)
+      return 0;
+
+    sent = enet_socket_send_batch (host -> socket, host -> sendBatchAddresses, host -> sendBatch, host -> sendBatchCount);
+
+    host -> sendBatchCount = 0;
+
+    if (sent < 0)
+      return -1;
+
+    host -> totalSentPackets += sent;
+    for (datagram = 0; datagram < sent; ++ datagram)
+      host -> totalSentData += host -> sendBatch [datagram].dataLength;
+
+    return 0;
+}
+
+/** Copies the datagram gathered in host -> buffers into the send batch, the buffers can be reused right away */
+static int
+enet_protocol_queue_datagram (ENetHost * host, const ENetAddress * address)
+{
+    ENetBuffer * datagram;
+    const ENetBuffer * buffer;
+    enet_uint8 * data;
+
+    if (host -> sendBatchCount >= ENET_SOCKET_BATCH_SIZE &&
+        enet_protocol_flush_send_batch (host) < 0)
+      return -1;
+
+    datagram = & host -> sendBatch [host -> sendBatchCount];
+    data = (enet_uint8 *) datagram -> data;
+    datagram -> dataLength = 0;
+
+    for (buffer = host -> buffers; buffer < & host -> buffers [host -> bufferCount]; ++ buffer)
+    {
+        memcpy (& data [datagram -> dataLength], buffer -> data, buffer -> dataLength);
+        datagram -> dataLength += buffer -> dataLength;
+    }
+
+    host -> sendBatchAddresses [host -> sendBatchCount ++] = * address;
+
+    return 0;
+}
+
+static int
+enet_protocol_queue_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
 {
     enet_uint8 headerData [sizeof (ENetProtocolHeader) + sizeof (enet_uint32)];
     ENetProtocolHeader * header = (ENetProtocolHeader *) headerData;
@@ -1608,10 +1737,15 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
     enet_list_clear (& sentUnreliableCommands);
 
     for (int sendPass = 0, continueSending = 0; sendPass <= continueSending; ++ sendPass)
-    for (ENetPeer * currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    for (ENetListIterator currentNode = enet_list_begin (& host -> activePeers), nextNode;
+         currentNode != enet_list_end (& host -> activePeers);
+         currentNode = nextNode)
     {
+        ENetPeer * currentPeer = ENET_ACTIVE_PEER (currentNode);
+
+        /* a timeout below may reset the peer, taking it off the list */
+        nextNode = enet_list_next (currentNode);
+
         if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED ||
             currentPeer -> state == ENET_PEER_STATE_ZOMBIE ||
             (sendPass > 0 && ! (currentPeer -> flags & ENET_PEER_FLAG_CONTINUE_SENDING)))
@@ -1724,16 +1858,13 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
 
         currentPeer -> lastSendTime = host -> serviceTime;
 
-        sentLength = enet_socket_send (host -> socket, & currentPeer -> address, host -> buffers, host -> bufferCount);
+        sentLength = enet_protocol_queue_datagram (host, & currentPeer -> address);
 
         enet_protocol_remove_sent_unreliable_commands (currentPeer, & sentUnreliableCommands);
 
         if (sentLength < 0)
           return -1;
 
-        host -> totalSentData += sentLength;
-        host -> totalSentPackets ++;
-
     nextPeer:
         if (currentPeer -> flags & ENET_PEER_FLAG_CONTINUE_SENDING)
           continueSending = sendPass + 1;
@@ -1742,6 +1873,19 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
     return 0;
 }
 
+/** Builds a datagram for every peer with something to send and sends them all with batched sends,
+    so a broadcast costs one system call per ENET_SOCKET_BATCH_SIZE peers instead of one per peer */
+static int
+enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
+{
+    int result = enet_protocol_queue_outgoing_commands (host, event, checkForTimeouts);
+
+    if (enet_protocol_flush_send_batch (host) < 0)
+      return -1;
+
+    return result;
+}
+
 /** Sends any queued packets on the host specified to its designated peers.
 
     @param host   host to flush
@@ -1897,6 +2041,13 @@ enet_host_service (ENetHost * host, ENetEvent * event, enet_uint32 timeout)
        if (ENET_TIME_GREATER_EQUAL (host -> serviceTime, timeout))
          return 0;
 
+       /* Datagrams left over from the last batched receive are already off the socket, don't wait for it */
+       if (host -> receiveBatchIndex < host -> receiveBatchCount)
+       {
+          waitCondition = ENET_SOCKET_WAIT_RECEIVE;
+          continue;
+       }
+
        do
        {
           host -> serviceTime = enet_time_get ();
@@ -1906,7 +2057,7 @@ enet_host_service (ENetHost * host, ENetEvent * event, enet_uint32 timeout)
 
           waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
 
-          if (enet_socket_wait (host -> socket, & waitCondition, ENET_TIME_DIFFERENCE (timeout, host -> serviceTime)) != 0)
+          if (enet_host_wait (host, & waitCondition, ENET_TIME_DIFFERENCE (timeout, host -> serviceTime)) != 0)
             return -1;
        }
        while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
@@ -4,6 +4,10 @@
 */
 #ifndef _WIN32
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* recvmmsg and sendmmsg */
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
@@ -22,6 +26,9 @@
 #ifdef HAS_POLL
 #undef HAS_POLL
 #endif
+#ifdef HAS_EPOLL
+#undef HAS_EPOLL
+#endif
 #ifndef HAS_FCNTL
 #define HAS_FCNTL 1
 #endif
@@ -53,6 +60,14 @@
 #include <poll.h>
 #endif
 
+#ifdef HAS_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#if defined(__linux__) && !defined(HAS_MMSG)
+#define HAS_MMSG 1
+#endif
+
 #if !defined(HAS_SOCKLEN_T) && !defined(__socklen_t_defined)
 typedef int socklen_t;
 #endif
@@ -66,6 +81,8 @@ static enet_uint32 timeBase = 0;
 int
 enet_initialize (void)
 {
+    enet_crc32_initialize ();
+
     return 0;
 }
 
@@ -83,21 +100,32 @@ enet_host_random_seed (void)
 enet_uint32
 enet_time_get (void)
 {
-    struct timeval timeVal;
+    struct timespec timeSpec;
+
+    /* Monotonic so timeouts and round trip times don't jump when the wall clock is adjusted */
+    clock_gettime (CLOCK_MONOTONIC, & timeSpec);
+
+    return timeSpec.tv_sec * 1000 + timeSpec.tv_nsec / 1000000 - timeBase;
+}
 
-    gettimeofday (& timeVal, NULL);
+enet_uint32
+enet_time_get_micros (void)
+{
+    struct timespec timeSpec;
 
-    return timeVal.tv_sec * 1000 + timeVal.tv_usec / 1000 - timeBase;
+    clock_gettime (CLOCK_MONOTONIC, & timeSpec);
+
+    return timeSpec.tv_sec * 1000000 + timeSpec.tv_nsec / 1000;
 }
 
 void
 enet_time_set (enet_uint32 newTimeBase)
 {
-    struct timeval timeVal;
+    struct timespec timeSpec;
 
-    gettimeofday (& timeVal, NULL);
+    clock_gettime (CLOCK_MONOTONIC, & timeSpec);
     
-    timeBase = timeVal.tv_sec * 1000 + timeVal.tv_usec / 1000 - newTimeBase;
+    timeBase = timeSpec.tv_sec * 1000 + timeSpec.tv_nsec / 1000000 - newTimeBase;
 }
 
 int
@@ -521,6 +549,147 @@ enet_socket_receive (ENetSocket socket,
     return recvLength;
 }
 
+/** Sends one datagram per buffer in buffers, datagram i to addresses [i], with as few system calls as possible.
+    Returns the number of datagrams sent, which is less than datagramCount if the socket would block, or -1 on error.
+*/
+int
+enet_socket_send_batch (ENetSocket socket,
+                        const ENetAddress * addresses,
+                        const ENetBuffer * buffers,
+                        size_t datagramCount)
+{
+#ifdef HAS_MMSG
+    struct mmsghdr messages [ENET_SOCKET_BATCH_SIZE];
+    struct sockaddr_in sins [ENET_SOCKET_BATCH_SIZE];
+    size_t sent = 0;
+
+    while (sent < datagramCount)
+    {
+        size_t count = datagramCount - sent, i;
+        int result;
+
+        if (count > ENET_SOCKET_BATCH_SIZE)
+          count = ENET_SOCKET_BATCH_SIZE;
+
+        memset (messages, 0, count * sizeof (struct mmsghdr));
+
+        for (i = 0; i < count; ++ i)
+        {
+            memset (& sins [i], 0, sizeof (struct sockaddr_in));
+
+            sins [i].sin_family = AF_INET;
+            sins [i].sin_port = ENET_HOST_TO_NET_16 (addresses [sent + i].port);
+            sins [i].sin_addr.s_addr = addresses [sent + i].host;
+
+            messages [i].msg_hdr.msg_name = & sins [i];
+            messages [i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+            messages [i].msg_hdr.msg_iov = (struct iovec *) & buffers [sent + i];
+            messages [i].msg_hdr.msg_iovlen = 1;
+        }
+
+        result = sendmmsg (socket, messages, count, MSG_NOSIGNAL);
+
+        if (result == -1)
+        {
+           if (errno == EWOULDBLOCK)
+             break;
+
+           return sent > 0 ? (int) sent : -1;
+        }
+
+        sent += result;
+    }
+
+    return (int) sent;
+#else
+    size_t sent;
+
+    for (sent = 0; sent < datagramCount; ++ sent)
+    {
+        int result = enet_socket_send (socket, & addresses [sent], & buffers [sent], 1);
+
+        if (result < 0)
+          return sent > 0 ? (int) sent : -1;
+
+        if (result == 0)
+          break;
+    }
+
+    return (int) sent;
+#endif
+}
+
+/** Receives up to datagramCount datagrams, one into each of buffers, with as few system calls as possible.
+    The length of datagram i is written to receivedLengths [i] (0 if it was truncated) and its sender to addresses [i].
+    Returns the number of datagrams received, 0 if none were waiting, or -1 on error.
+*/
+int
+enet_socket_receive_batch (ENetSocket socket,
+                           ENetAddress * addresses,
+                           ENetBuffer * buffers,
+                           size_t * receivedLengths,
+                           size_t datagramCount)
+{
+#ifdef HAS_MMSG
+    struct mmsghdr messages [ENET_SOCKET_BATCH_SIZE];
+    struct sockaddr_in sins [ENET_SOCKET_BATCH_SIZE];
+    int received, i;
+
+    if (datagramCount > ENET_SOCKET_BATCH_SIZE)
+      datagramCount = ENET_SOCKET_BATCH_SIZE;
+
+    memset (messages, 0, datagramCount * sizeof (struct mmsghdr));
+
+    for (i = 0; i < (int) datagramCount; ++ i)
+    {
+        messages [i].msg_hdr.msg_name = & sins [i];
+        messages [i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+        messages [i].msg_hdr.msg_iov = (struct iovec *) & buffers [i];
+        messages [i].msg_hdr.msg_iovlen = 1;
+    }
+
+    received = recvmmsg (socket, messages, datagramCount, MSG_NOSIGNAL, NULL);
+
+    if (received == -1)
+    {
+       if (errno == EWOULDBLOCK)
+         return 0;
+
+       return -1;
+    }
+
+    for (i = 0; i < received; ++ i)
+    {
+        receivedLengths [i] = (messages [i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : messages [i].msg_len;
+
+        addresses [i].host = (enet_uint32) sins [i].sin_addr.s_addr;
+        addresses [i].port = ENET_NET_TO_HOST_16 (sins [i].sin_port);
+    }
+
+    return received;
+#else
+    size_t received;
+
+    for (received = 0; received < datagramCount; ++ received)
+    {
+        int result = enet_socket_receive (socket, & addresses [received], & buffers [received], 1);
+
+        if (result == -2)
+          result = 0;
+        else
+        if (result < 0)
+          return received > 0 ? (int) received : -1;
+        else
+        if (result == 0)
+          break;
+
+        receivedLengths [received] = result;
+    }
+
+    return (int) received;
+#endif
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
@@ -620,5 +789,83 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
 #endif
 }
 
+/** Sets up waiting on the host's socket. With HAS_EPOLL the socket is registered once with an epoll instance
+    owned by the host, so each wait is a single epoll_wait instead of rebuilding a poll or select set.
+    Returns 0 on success (also when there is nothing to set up) or -1 on error.
+*/
+int
+enet_host_wait_create (ENetHost * host)
+{
+#ifdef HAS_EPOLL
+    struct epoll_event event;
+
+    host -> waitDescriptor = epoll_create1 (EPOLL_CLOEXEC);
+    if (host -> waitDescriptor < 0)
+      return -1;
+
+    memset (& event, 0, sizeof (struct epoll_event));
+    event.events = EPOLLIN;
+    event.data.fd = host -> socket;
+
+    if (epoll_ctl (host -> waitDescriptor, EPOLL_CTL_ADD, host -> socket, & event) < 0)
+    {
+        close (host -> waitDescriptor);
+        host -> waitDescriptor = -1;
+
+        return -1;
+    }
+#else
+    host -> waitDescriptor = -1;
+#endif
+
+    return 0;
+}
+
+void
+enet_host_wait_destroy (ENetHost * host)
+{
+    if (host -> waitDescriptor >= 0)
+      close (host -> waitDescriptor);
+
+    host -> waitDescriptor = -1;
+}
+
+/** Same as enet_socket_wait on the host's socket, through the host's epoll instance if it has one */
+int
+enet_host_wait (ENetHost * host, enet_uint32 * condition, enet_uint32 timeout)
+{
+#ifdef HAS_EPOLL
+    struct epoll_event event;
+    int eventCount;
+
+    /* Only readability is registered */
+    if (host -> waitDescriptor < 0 || (* condition & ENET_SOCKET_WAIT_SEND))
+      return enet_socket_wait (host -> socket, condition, timeout);
+
+    eventCount = epoll_wait (host -> waitDescriptor, & event, 1, (int) timeout);
+
+    if (eventCount < 0)
+    {
+        if (errno == EINTR && * condition & ENET_SOCKET_WAIT_INTERRUPT)
+        {
+            * condition = ENET_SOCKET_WAIT_INTERRUPT;
+
+            return 0;
+        }
+
+        return -1;
+    }
+
+    * condition = ENET_SOCKET_WAIT_NONE;
+
+    if (eventCount > 0 && (event.events & (EPOLLIN | EPOLLERR)))
+      * condition |= ENET_SOCKET_WAIT_RECEIVE;
+
+    return 0;
+#else
+    return enet_socket_wait (host -> socket, condition, timeout);
+#endif
+}
+
 #endif
 
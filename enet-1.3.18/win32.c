@@ -17,6 +17,8 @@ enet_initialize (void)
 {
     WORD versionRequested = MAKEWORD (1, 1);
     WSADATA wsaData;
+
+    enet_crc32_initialize ();
    
     if (WSAStartup (versionRequested, & wsaData))
        return -1;
@@ -54,6 +56,18 @@ enet_time_get (void)
     return (enet_uint32) timeGetTime () - timeBase;
 }
 
+enet_uint32
+enet_time_get_micros (void)
+{
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceFrequency (& frequency);
+    QueryPerformanceCounter (& counter);
+
+    return (enet_uint32) (counter.QuadPart / frequency.QuadPart * 1000000 +
+                          counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
+
 void
 enet_time_set (enet_uint32 newTimeBase)
 {
@@ -401,6 +415,56 @@ enet_socket_receive (ENetSocket socket,
     return (int) recvLength;
 }
 
+int
+enet_socket_send_batch (ENetSocket socket,
+                        const ENetAddress * addresses,
+                        const ENetBuffer * buffers,
+                        size_t datagramCount)
+{
+    size_t sent;
+
+    for (sent = 0; sent < datagramCount; ++ sent)
+    {
+        int result = enet_socket_send (socket, & addresses [sent], & buffers [sent], 1);
+
+        if (result < 0)
+          return sent > 0 ? (int) sent : -1;
+
+        if (result == 0)
+          break;
+    }
+
+    return (int) sent;
+}
+
+int
+enet_socket_receive_batch (ENetSocket socket,
+                           ENetAddress * addresses,
+                           ENetBuffer * buffers,
+                           size_t * receivedLengths,
+                           size_t datagramCount)
+{
+    size_t received;
+
+    for (received = 0; received < datagramCount; ++ received)
+    {
+        int result = enet_socket_receive (socket, & addresses [received], & buffers [received], 1);
+
+        if (result == -2)
+          result = 0;
+        else
+        if (result < 0)
+          return received > 0 ? (int) received : -1;
+        else
+        if (result == 0)
+          break;
+
+        receivedLengths [received] = result;
+    }
+
+    return (int) received;
+}
+
 int
 enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocketSet * writeSet, enet_uint32 timeout)
 {
@@ -450,5 +514,24 @@ enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeou
     return 0;
 } 
 
+int
+enet_host_wait_create (ENetHost * host)
+{
+    host -> waitDescriptor = -1;
+
+    return 0;
+}
+
+void
+enet_host_wait_destroy (ENetHost * host)
+{
+}
+
+int
+enet_host_wait (ENetHost * host, enet_uint32 * condition, enet_uint32 timeout)
+{
+    return enet_socket_wait (host -> socket, condition, timeout);
+}
+
 #endif
 
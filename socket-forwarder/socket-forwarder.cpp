@@ -36,6 +36,18 @@ void runENet()
         exit(EXIT_FAILURE);
     }
 
+    // Must match the server, which checksums its datagrams when started with ENET_CHECKSUM=1
+    const char *checksum = getenv("ENET_CHECKSUM");
+    if (checksum != NULL && strcmp(checksum, "1") == 0)
+        client->checksum = enet_crc32;
+
+    // Must also match the server's ENET_COMPRESS
+    const char *compressor = getenv("ENET_COMPRESS");
+    if (compressor != NULL && strcmp(compressor, "lz") == 0)
+        enet_host_compress_with_lz(client);
+    else if (compressor != NULL && strcmp(compressor, "range") == 0)
+        enet_host_compress_with_range_coder(client);
+
     // Connect to host address
     std::string host;
     std::cout << "Enter host address: ";
@@ -75,11 +87,25 @@ void runENet()
 
 void onIncomingPacket(PacketData data, ServerHandler *server)
 {
-    std::cout << "Client -> Server: " << data.rawMessage << std::endl;
+    std::cout << "Client -> Server: " << data.rawMessage() << std::endl;
 
-    // Send packet to server
-    ENetPacket *packet = enet_packet_create(data.rawMessage.c_str(), data.rawMessage.size(), ENET_PACKET_FLAG_RELIABLE);
-    enet_peer_send(client->peers, 0, packet);
+    // Send packet to server, motion unsequenced with a sequence number and everything else reliable
+    static uint16_t motionSequence = 0;
+    ENetPacket *packet;
+    if (isMotionPacket(data.bytes, data.length))
+    {
+        uint8_t motion[MAX_MOTION_PACKET_LENGTH];
+        std::memcpy(motion, data.bytes, data.length);
+        if (data.length < MAX_MOTION_PACKET_LENGTH)
+            setMotionSequence(motion, motionSequence++);
+        packet = enet_packet_create(motion, MAX_MOTION_PACKET_LENGTH, ENET_PACKET_FLAG_UNSEQUENCED);
+        enet_peer_send(client->peers, MOTION_CHANNEL, packet);
+    }
+    else
+    {
+        packet = enet_packet_create(data.bytes, data.length, ENET_PACKET_FLAG_RELIABLE);
+        enet_peer_send(client->peers, CONTROL_CHANNEL, packet);
+    }
     enet_host_flush(client);
 }
 
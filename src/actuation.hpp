@@ -0,0 +1,358 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "packet.hpp"
+#include "callback.hpp"
+#include "seqlock.hpp"
+#include "spsc.hpp"
+#include "trace.hpp"
+
+#define ACTUATION_QUEUE_SIZE 64 // Macros and stops that can wait for the actuation thread
+
+// Decoded command handed from the network thread to the actuation thread
+struct ActuationCommand
+{
+    enum Type
+    {
+        MOTION,
+        MACRO,
+        STOP
+    };
+
+    Type type;
+    MotionCommand motion;    // Only valid when type is MOTION
+    MacroCommand macro;      // Only valid when type is MACRO
+    int64_t enqueuedAt;      // CLOCK_MONOTONIC time in ns when it was submitted
+    uint64_t motionSequence; // Motion commands submitted up to this one, counting it if it is motion
+#ifdef LATENCY_TRACE
+    int64_t traceOrigin; // Latency trace the submitting thread was running, continued when the command is applied
+#endif
+};
+
+// Snapshot of the actuation thread counters
+struct ActuationStats
+{
+    unsigned long submitted;     // Commands submitted
+    unsigned long applied;       // Commands handed to the appliers
+    unsigned long coalesced;     // Motion commands replaced by a newer one before being applied
+    std::size_t queueDepth;      // Commands waiting right now
+    std::size_t maxQueueDepth;   // Most commands ever seen waiting at once
+    int64_t lastLatencyNs;       // Enqueue to apply time of the last applied command
+    int64_t maxLatencyNs;        // Worst enqueue to apply time
+    int64_t meanLatencyNs;       // Average enqueue to apply time
+    unsigned long ticks;         // Control loop ticks run (fixed rate mode only)
+    unsigned long overruns;      // Ticks that finished after the next deadline, missed deadlines are skipped
+    int64_t lastJitterNs;        // How late the last tick woke up after its deadline
+    int64_t maxJitterNs;         // Latest any tick woke up
+    int64_t meanJitterNs;        // Average tick wake up lateness
+};
+
+// Runs motor actuation on its own thread so slow GPIO writes never delay the next network receive
+// Only the newest motion setpoint matters, so submitting motion replaces the one waiting in a single slot and never blocks
+// Macros and stops go through an SPSC ring and all run in order, submitting one only blocks if the ring is full
+// Started with a rate it runs as a fixed rate control loop: it wakes on absolute deadlines and applies the newest
+// command once per tick, so actuation latency doesn't depend on when packets happen to arrive
+// Only one thread may submit commands
+class ActuationThread
+{
+public:
+    typedef InplaceFunction<void(const MotionCommand &)> MotionApplier;
+    typedef InplaceFunction<void(const MacroCommand &)> MacroApplier;
+    typedef InplaceFunction<void()> StopApplier;
+
+private:
+    SpscRing<ActuationCommand, ACTUATION_QUEUE_SIZE> queue; // Macros and stops
+    Seqlock<ActuationCommand> latestMotion;                 // Newest motion command
+    sem_t wakeup; // Posted once per submitted command so the actuation thread can sleep while idle
+
+    MotionApplier applyMotion;
+    MacroApplier applyMacro;
+    StopApplier applyStop;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    unsigned int rateHz = 0; // Control loop rate, 0 to apply commands as soon as they arrive
+
+    // Only written by the submitting thread
+    std::atomic<unsigned long> submitted{0};
+    uint64_t motionSubmitted = 0;
+
+    // Only written by the actuation thread
+    uint64_t motionTaken = 0; // motionSequence of the last motion command applied, or thrown away by a stop
+    std::atomic<unsigned long> applied{0};
+    std::atomic<unsigned long> coalesced{0};
+    std::atomic<std::size_t> maxQueueDepth{0};
+    std::atomic<int64_t> lastLatencyNs{0};
+    std::atomic<int64_t> maxLatencyNs{0};
+    std::atomic<int64_t> totalLatencyNs{0};
+    std::atomic<unsigned long> ticks{0};
+    std::atomic<unsigned long> overruns{0};
+    std::atomic<int64_t> lastJitterNs{0};
+    std::atomic<int64_t> maxJitterNs{0};
+    std::atomic<int64_t> totalJitterNs{0};
+
+    // CLOCK_MONOTONIC time in ns
+    static int64_t now()
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+    }
+
+    void submit(ActuationCommand &command)
+    {
+        command.enqueuedAt = now();
+#ifdef LATENCY_TRACE
+        command.traceOrigin = command.type == ActuationCommand::MOTION ? TRACE_ORIGIN() : 0;
+#endif
+        if (command.type == ActuationCommand::MOTION)
+        {
+            command.motionSequence = ++motionSubmitted;
+            latestMotion.store(command);
+        }
+        else
+        {
+            // Macros and stops must never be lost, if the ring is full wait for the actuation thread to free a slot
+            command.motionSequence = motionSubmitted;
+            while (!queue.push(command))
+            {
+                sem_post(&wakeup);
+                std::this_thread::yield();
+            }
+        }
+
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        sem_post(&wakeup);
+    }
+
+    // Applies one command and records how long it waited
+    void apply(const ActuationCommand &command)
+    {
+        TRACE_ADOPT(command.traceOrigin);
+        switch (command.type)
+        {
+        case ActuationCommand::MOTION:
+            if (applyMotion != nullptr)
+                applyMotion(command.motion);
+            break;
+        case ActuationCommand::MACRO:
+            if (applyMacro != nullptr)
+                applyMacro(command.macro);
+            break;
+        case ActuationCommand::STOP:
+            if (applyStop != nullptr)
+                applyStop();
+            break;
+        }
+        TRACE_END();
+
+        int64_t latency = now() - command.enqueuedAt;
+        lastLatencyNs.store(latency, std::memory_order_relaxed);
+        totalLatencyNs.fetch_add(latency, std::memory_order_relaxed);
+        if (latency > maxLatencyNs.load(std::memory_order_relaxed))
+            maxLatencyNs.store(latency, std::memory_order_relaxed);
+        applied.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Applies <command>, read from latestMotion, unless it was already applied or is newer than motion number <until>
+    void applyNewMotion(const ActuationCommand &command, uint64_t until)
+    {
+        if (command.motionSequence <= motionTaken || command.motionSequence > until)
+            return;
+
+        coalesced.fetch_add(command.motionSequence - motionTaken - 1, std::memory_order_relaxed);
+        motionTaken = command.motionSequence;
+        apply(command);
+    }
+
+    // Runs every queued macro and stop in order, then applies the newest motion command
+    void drainQueue()
+    {
+        std::size_t depth = queue.size();
+        if (depth > maxQueueDepth.load(std::memory_order_relaxed))
+            maxQueueDepth.store(depth, std::memory_order_relaxed);
+
+        ActuationCommand command;
+        for (;;)
+        {
+            while (queue.pop(command))
+            {
+                // A stop throws away motion that was submitted before it, a macro runs after it
+                if (command.type == ActuationCommand::STOP)
+                {
+                    if (command.motionSequence > motionTaken)
+                        motionTaken = command.motionSequence;
+                }
+                else
+                {
+                    applyNewMotion(latestMotion.load(), command.motionSequence);
+                }
+                apply(command);
+            }
+
+            // A macro or stop submitted before the newest motion has to run first, so check the ring again after reading it
+            ActuationCommand latest = latestMotion.load();
+            if (queue.size() == 0)
+            {
+                applyNewMotion(latest, UINT64_MAX);
+                return;
+            }
+        }
+    }
+
+    static timespec fromNanos(int64_t nanos)
+    {
+        timespec time;
+        time.tv_sec = nanos / 1000000000;
+        time.tv_nsec = nanos % 1000000000;
+        return time;
+    }
+
+    // Applies commands as soon as they are submitted
+    void eventLoop()
+    {
+        while (running.load(std::memory_order_acquire))
+        {
+            sem_wait(&wakeup);
+            drainQueue();
+        }
+        drainQueue();
+    }
+
+    // Applies the newest commands once every 1 / rateHz seconds
+    void tickLoop()
+    {
+        // Ask for real time scheduling so ticks aren't delayed by other threads, needs root and is skipped otherwise
+        sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+        const int64_t period = 1000000000LL / rateHz;
+        int64_t deadline = now();
+
+        while (running.load(std::memory_order_acquire))
+        {
+            deadline += period;
+            timespec wake = fromNanos(deadline);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR)
+            {
+            }
+
+            int64_t jitter = now() - deadline;
+            lastJitterNs.store(jitter, std::memory_order_relaxed);
+            totalJitterNs.fetch_add(jitter, std::memory_order_relaxed);
+            if (jitter > maxJitterNs.load(std::memory_order_relaxed))
+                maxJitterNs.store(jitter, std::memory_order_relaxed);
+
+            // The ring is polled every tick, so the wakeups posted by submit aren't needed
+            while (sem_trywait(&wakeup) == 0)
+            {
+            }
+            drainQueue();
+            ticks.fetch_add(1, std::memory_order_relaxed);
+
+            // Skip the deadlines this tick ran over instead of bursting to catch up
+            int64_t finished = now();
+            if (finished > deadline + period)
+            {
+                overruns.fetch_add(1, std::memory_order_relaxed);
+                deadline += (finished - deadline) / period * period;
+            }
+        }
+        drainQueue();
+    }
+
+    void loop()
+    {
+        if (rateHz == 0)
+            eventLoop();
+        else
+            tickLoop();
+    }
+
+public:
+    ActuationThread(MotionApplier applyMotion, MacroApplier applyMacro = nullptr, StopApplier applyStop = nullptr)
+        : applyMotion(std::move(applyMotion)),
+          applyMacro(std::move(applyMacro)),
+          applyStop(std::move(applyStop))
+    {
+        sem_init(&wakeup, 0, 0);
+    }
+
+    ~ActuationThread()
+    {
+        stop();
+        sem_destroy(&wakeup);
+    }
+
+    // Starts the actuation thread, as a fixed rate control loop at <rateHz> or applying commands as they arrive if 0
+    void start(unsigned int rateHz = 0)
+    {
+        if (running.exchange(true))
+            return;
+        this->rateHz = rateHz;
+        thread = std::thread(&ActuationThread::loop, this);
+    }
+
+    // Applies whatever is still queued and joins the actuation thread
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        sem_post(&wakeup);
+        thread.join();
+    }
+
+    // Make <motion> the next motion command to apply, replacing one that wasn't applied yet
+    void submitMotion(const MotionCommand &motion)
+    {
+        ActuationCommand command = {};
+        command.type = ActuationCommand::MOTION;
+        command.motion = motion;
+        submit(command);
+    }
+
+    // Queue a macro command, blocks while ACTUATION_QUEUE_SIZE macros and stops are already waiting
+    void submitMacro(const MacroCommand &macro)
+    {
+        ActuationCommand command = {};
+        command.type = ActuationCommand::MACRO;
+        command.macro = macro;
+        submit(command);
+    }
+
+    // Queue a stop of all movement, blocks while ACTUATION_QUEUE_SIZE macros and stops are already waiting
+    void submitStop()
+    {
+        ActuationCommand command = {};
+        command.type = ActuationCommand::STOP;
+        submit(command);
+    }
+
+    ActuationStats getStats() const
+    {
+        ActuationStats stats;
+        stats.submitted = submitted.load(std::memory_order_relaxed);
+        stats.applied = applied.load(std::memory_order_relaxed);
+        stats.coalesced = coalesced.load(std::memory_order_relaxed);
+        stats.queueDepth = queue.size();
+        stats.maxQueueDepth = maxQueueDepth.load(std::memory_order_relaxed);
+        stats.lastLatencyNs = lastLatencyNs.load(std::memory_order_relaxed);
+        stats.maxLatencyNs = maxLatencyNs.load(std::memory_order_relaxed);
+        stats.meanLatencyNs = stats.applied > 0 ? totalLatencyNs.load(std::memory_order_relaxed) / (int64_t)stats.applied : 0;
+        stats.ticks = ticks.load(std::memory_order_relaxed);
+        stats.overruns = overruns.load(std::memory_order_relaxed);
+        stats.lastJitterNs = lastJitterNs.load(std::memory_order_relaxed);
+        stats.maxJitterNs = maxJitterNs.load(std::memory_order_relaxed);
+        stats.meanJitterNs = stats.ticks > 0 ? totalJitterNs.load(std::memory_order_relaxed) / (int64_t)stats.ticks : 0;
+        return stats;
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, std::size_t Capacity = 48>
+class InplaceFunction;
+
+// Callable wrapper like std::function that never allocates
+// The callable is stored inside the wrapper, anything bigger than <Capacity> bytes is a compile error
+template <typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+private:
+    // Operations the type-erased manager knows how to do with the stored callable
+    enum Operation
+    {
+        MOVE,
+        DESTROY
+    };
+
+    // Callables that can be empty, everything else (lambdas, functors, functions) always holds something
+    template <typename F>
+    struct Nullable : std::integral_constant<bool, std::is_pointer<F>::value || std::is_member_pointer<F>::value>
+    {
+    };
+
+    template <typename Signature>
+    struct Nullable<std::function<Signature>> : std::true_type
+    {
+    };
+
+    typedef R (*Invoker)(void *, Args...);
+    typedef void (*Manager)(Operation, void *, void *);
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    Invoker invoker = nullptr; // Calls the stored callable, null when empty
+    Manager manager = nullptr; // Moves or destroys the stored callable, null when empty
+
+    template <typename F>
+    static R invoke(void *callable, Args... args)
+    {
+        return (*static_cast<F *>(callable))(std::forward<Args>(args)...);
+    }
+
+    template <typename F>
+    static void manage(Operation operation, void *dst, void *src)
+    {
+        if (operation == MOVE)
+        {
+            new (dst) F(std::move(*static_cast<F *>(src)));
+        }
+        static_cast<F *>(src)->~F();
+    }
+
+    void reset()
+    {
+        if (manager != nullptr)
+        {
+            manager(DESTROY, nullptr, storage);
+        }
+        invoker = nullptr;
+        manager = nullptr;
+    }
+
+    void moveFrom(InplaceFunction &other)
+    {
+        if (other.manager != nullptr)
+        {
+            other.manager(MOVE, storage, other.storage);
+            invoker = other.invoker;
+            manager = other.manager;
+            other.invoker = nullptr;
+            other.manager = nullptr;
+        }
+    }
+
+public:
+    InplaceFunction() {}
+
+    InplaceFunction(std::nullptr_t) {}
+
+    // Wraps any callable (function pointer, lambda, functor) that fits inside the buffer
+    template <typename F, typename Decayed = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Decayed, InplaceFunction>::value>::type>
+    InplaceFunction(F &&callable)
+    {
+        static_assert(sizeof(Decayed) <= Capacity, "Callable is too big for InplaceFunction, raise Capacity");
+        static_assert(alignof(Decayed) <= alignof(std::max_align_t), "Callable is over-aligned for InplaceFunction");
+
+        // Empty function pointers and std::functions leave the wrapper empty
+        if constexpr (Nullable<Decayed>::value)
+        {
+            const Decayed &decayed = callable;
+            if (!static_cast<bool>(decayed))
+            {
+                return;
+            }
+        }
+
+        new (storage) Decayed(std::forward<F>(callable));
+        invoker = &invoke<Decayed>;
+        manager = &manage<Decayed>;
+    }
+
+    InplaceFunction(InplaceFunction &&other)
+    {
+        moveFrom(other);
+    }
+
+    InplaceFunction &operator=(InplaceFunction &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction &operator=(std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction &) = delete;
+    InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+    ~InplaceFunction()
+    {
+        reset();
+    }
+
+    R operator()(Args... args) const
+    {
+        return invoker(const_cast<unsigned char *>(storage), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+        return invoker != nullptr;
+    }
+
+    bool operator==(std::nullptr_t) const
+    {
+        return invoker == nullptr;
+    }
+
+    bool operator!=(std::nullptr_t) const
+    {
+        return invoker != nullptr;
+    }
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "callback.hpp"
+#include "seqlock.hpp"
+
+#define DASHBOARD_RATE 10 // Redraws per second
+
+// Whether <fd1> and <fd2> are both the same terminal
+inline bool sameTerminal(int fd1, int fd2)
+{
+    struct stat stat1, stat2;
+    if (!isatty(fd1) || !isatty(fd2) || fstat(fd1, &stat1) != 0 || fstat(fd2, &stat2) != 0)
+        return false;
+    return stat1.st_rdev == stat2.st_rdev;
+}
+
+// Console status screen redrawn by its own thread
+// The control path only publishes the newest <State> (a non-blocking copy), the dashboard thread renders it at a
+// fixed low rate and redraws in place with ANSI cursor control in a single write
+template <typename State>
+class Dashboard
+{
+public:
+    // Writes the screen contents for a state, one line per '\n'
+    typedef InplaceFunction<void(const State &, std::ostream &)> Renderer;
+
+private:
+    Seqlock<State> state;
+    Renderer render;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    unsigned int rateHz;
+
+    void run()
+    {
+        std::ostringstream contents;
+        std::string frame;
+
+        while (running.load(std::memory_order_acquire))
+        {
+            contents.str("");
+            render(state.load(), contents);
+            const std::string text = contents.str();
+
+            // Home the cursor, clear the rest of each line and everything below the last one
+            frame = "\x1b[H";
+            for (char c : text)
+            {
+                if (c == '\n')
+                    frame += "\x1b[K";
+                frame += c;
+            }
+            frame += "\x1b[J";
+
+            ssize_t ignored = ::write(STDOUT_FILENO, frame.data(), frame.size());
+            (void)ignored;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000 / rateHz));
+        }
+    }
+
+public:
+    Dashboard(Renderer render, unsigned int rateHz = DASHBOARD_RATE)
+        : render(std::move(render)), rateHz(rateHz > 0 ? rateHz : 1)
+    {
+    }
+
+    ~Dashboard()
+    {
+        stop();
+    }
+
+    // Clears the screen and starts the redraw thread
+    void start()
+    {
+        if (running.exchange(true))
+            return;
+        ssize_t ignored = ::write(STDOUT_FILENO, "\x1b[2J", 4);
+        (void)ignored;
+        thread = std::thread(&Dashboard::run, this);
+    }
+
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        thread.join();
+    }
+
+    // Replace the state shown on the next redraw, never blocks (single publishing thread only)
+    void publish(const State &newState)
+    {
+        state.store(newState);
+    }
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <enet/enet.h>
+
+#define ENET_POOL_PAYLOAD_SIZE 64 // Largest packet payload served from the payload pool, motion and status messages fit
+#define ENET_POOL_SLOT_ALIGN 16
+
+// Fixed number of equal slots carved out of one block, free slots are linked through their first bytes
+// Not thread safe, like the rest of ENet it may only be used from one thread at a time
+// The counters are atomics so other threads can read them for display
+class SlabPool
+{
+private:
+    uint8_t *begin = nullptr;
+    uint8_t *end = nullptr;
+    void *freeList = nullptr;
+    std::size_t minSize = 0, maxSize = 0, slotSize = 0, capacity = 0;
+
+    std::atomic<std::size_t> inUse{0};
+    std::atomic<std::size_t> highWater{0};
+    std::atomic<unsigned long> allocations{0};
+    std::atomic<unsigned long> overflows{0}; // Allocations that went to malloc because every slot was taken
+
+    // Counters only change on the ENet thread, so plain load/store is enough
+    static void increment(std::atomic<unsigned long> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+public:
+    const char *name = "";
+
+    // Serves sizes from <min> to <max> bytes, <capacity> of them at once
+    void init(const char *poolName, std::size_t min, std::size_t max, std::size_t slots)
+    {
+        name = poolName;
+        minSize = min;
+        maxSize = max;
+        slotSize = (max + ENET_POOL_SLOT_ALIGN - 1) / ENET_POOL_SLOT_ALIGN * ENET_POOL_SLOT_ALIGN;
+        capacity = slots;
+        begin = (uint8_t *)std::malloc(slotSize * capacity);
+        end = begin != nullptr ? begin + slotSize * capacity : nullptr;
+
+        // Link the slots in address order so the first allocations are next to each other
+        freeList = nullptr;
+        for (std::size_t i = capacity; begin != nullptr && i-- > 0;)
+        {
+            void *slot = begin + i * slotSize;
+            *(void **)slot = freeList;
+            freeList = slot;
+        }
+    }
+
+    bool fits(std::size_t size) const
+    {
+        return size >= minSize && size <= maxSize;
+    }
+
+    bool owns(const void *memory) const
+    {
+        return memory >= begin && memory < end;
+    }
+
+    // Returns a slot, or nullptr if they are all taken
+    void *allocate()
+    {
+        increment(allocations);
+        void *slot = freeList;
+        if (slot == nullptr)
+        {
+            increment(overflows);
+            return nullptr;
+        }
+        freeList = *(void **)slot;
+
+        std::size_t used = inUse.load(std::memory_order_relaxed) + 1;
+        inUse.store(used, std::memory_order_relaxed);
+        if (used > highWater.load(std::memory_order_relaxed))
+            highWater.store(used, std::memory_order_relaxed);
+        return slot;
+    }
+
+    // Returns a slot this pool owns
+    void release(void *slot)
+    {
+        *(void **)slot = freeList;
+        freeList = slot;
+        inUse.store(inUse.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    std::size_t getSlotSize() const { return slotSize; }
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getInUse() const { return inUse.load(std::memory_order_relaxed); }
+    std::size_t getHighWater() const { return highWater.load(std::memory_order_relaxed); }
+    unsigned long getAllocations() const { return allocations.load(std::memory_order_relaxed); }
+    unsigned long getOverflows() const { return overflows.load(std::memory_order_relaxed); }
+};
+
+// Slab pools behind enet_malloc/enet_free for the small objects ENet allocates per packet
+// ENetCallbacks only passes the size, so objects are classed by their exact size and packet payloads by range
+// Anything else (hosts, peers, channel arrays, large payloads) still goes to malloc
+namespace EnetPool
+{
+    enum Class
+    {
+        PACKET,
+        OUTGOING_COMMAND,
+        INCOMING_COMMAND,
+        ACKNOWLEDGEMENT,
+        PAYLOAD, // Checked last, a payload the exact size of an object lands in that object's pool
+        CLASS_COUNT
+    };
+
+    inline SlabPool *pools()
+    {
+        static SlabPool classes[CLASS_COUNT];
+        return classes;
+    }
+
+    // Allocations too big for any pool
+    inline std::atomic<unsigned long> &heapAllocations()
+    {
+        static std::atomic<unsigned long> count{0};
+        return count;
+    }
+
+    inline void *ENET_CALLBACK allocate(size_t size)
+    {
+        SlabPool *classes = pools();
+        for (int i = 0; i < CLASS_COUNT; i++)
+        {
+            if (!classes[i].fits(size))
+                continue;
+            void *slot = classes[i].allocate();
+            if (slot != nullptr)
+                return slot;
+            break;
+        }
+
+        std::atomic<unsigned long> &heap = heapAllocations();
+        heap.store(heap.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return std::malloc(size);
+    }
+
+    inline void ENET_CALLBACK release(void *memory)
+    {
+        SlabPool *classes = pools();
+        for (int i = 0; i < CLASS_COUNT; i++)
+        {
+            if (classes[i].owns(memory))
+            {
+                classes[i].release(memory);
+                return;
+            }
+        }
+        std::free(memory);
+    }
+
+    // Sets up the pools and initializes ENet to allocate from them, call instead of enet_initialize
+    // Returns what enet_initialize returns
+    inline int initialize()
+    {
+        static bool created = false;
+        if (!created)
+        {
+            SlabPool *classes = pools();
+            classes[PACKET].init("packet", sizeof(ENetPacket), sizeof(ENetPacket), 256);
+            classes[OUTGOING_COMMAND].init("outgoing", sizeof(ENetOutgoingCommand), sizeof(ENetOutgoingCommand), 512);
+            classes[INCOMING_COMMAND].init("incoming", sizeof(ENetIncomingCommand), sizeof(ENetIncomingCommand), 256);
+            classes[ACKNOWLEDGEMENT].init("ack", sizeof(ENetAcknowledgement), sizeof(ENetAcknowledgement), 256);
+            classes[PAYLOAD].init("payload", 1, ENET_POOL_PAYLOAD_SIZE, 256);
+            created = true;
+        }
+
+        ENetCallbacks callbacks = {allocate, release, nullptr};
+        return enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+    }
+}
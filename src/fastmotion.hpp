@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "packet.hpp"
+#include "siphash.hpp"
+
+// Compact motion datagram sent as a raw UDP packet to the ENet port instead of inside an ENet packet, so the
+// server can decode it straight out of the receive buffer without ENet command parsing or a packet allocation
+//
+// <magic (4)> <sequence (2)> <motion (2)> <tag (8)>
+// - magic: FAST_MOTION_MAGIC, tells it apart from ENet protocol datagrams
+// - sequence: big endian motion sequence number, same meaning as bytes 3 and 4 of a 4 byte motion packet
+// - motion: bytes 1 and 2 of a motion packet
+// - tag: little endian SipHash-2-4 of the first 8 bytes under the 16 byte key shared with the server
+//
+// The sender must also hold an ENet connection to the server, datagrams from addresses without one are dropped
+namespace FastMotion
+{
+    constexpr uint8_t MAGIC[4] = {0xFF, 'M', 'O', 'V'};
+    constexpr std::size_t KEY_LENGTH = 16;
+    constexpr std::size_t SIGNED_LENGTH = 8; // Bytes covered by the tag
+    constexpr std::size_t LENGTH = SIGNED_LENGTH + 8;
+}
+
+// Fills <datagram> (FastMotion::LENGTH bytes) with a signed fast motion datagram
+inline void encodeFastMotion(uint8_t *datagram, const uint8_t *motion, uint16_t sequence, const uint8_t *key)
+{
+    std::memcpy(datagram, FastMotion::MAGIC, sizeof(FastMotion::MAGIC));
+    datagram[4] = sequence >> 8;
+    datagram[5] = sequence & 0xFF;
+    datagram[6] = motion[0];
+    datagram[7] = motion[1];
+
+    uint64_t tag = siphash24(key, datagram, FastMotion::SIGNED_LENGTH);
+    for (int i = 0; i < 8; i++)
+        datagram[FastMotion::SIGNED_LENGTH + i] = tag >> (8 * i);
+}
+
+// Returns true if <datagram> starts like a fast motion datagram, it still has to be verified
+inline bool isFastMotion(const uint8_t *datagram, std::size_t length)
+{
+    return length == FastMotion::LENGTH && std::memcmp(datagram, FastMotion::MAGIC, sizeof(FastMotion::MAGIC)) == 0;
+}
+
+// Checks the tag of a fast motion datagram and writes it out as a 4 byte (sequenced) motion packet
+// Returns false if the tag doesn't match or it doesn't hold a motion packet
+inline bool decodeFastMotion(const uint8_t *datagram, const uint8_t *key, uint8_t *motionPacket)
+{
+    uint64_t tag = siphash24(key, datagram, FastMotion::SIGNED_LENGTH);
+    uint64_t received = 0;
+    for (int i = 7; i >= 0; i--)
+        received = received << 8 | datagram[FastMotion::SIGNED_LENGTH + i];
+    if (tag != received)
+        return false;
+
+    motionPacket[0] = datagram[6];
+    motionPacket[1] = datagram[7];
+    motionPacket[2] = datagram[4];
+    motionPacket[3] = datagram[5];
+    return isMotionPacket(motionPacket, MAX_MOTION_PACKET_LENGTH);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <jetgpio.h>
+
+#define GPIO_SHADOW_PINS 41 // Header pins are numbered 1 to 40
+
+// Last level or PWM duty cycle written to each header pin, so writes that wouldn't change the hardware are skipped
+// Only knows about writes made through it, call invalidate after anything else changes the pins (gpioTerminate does)
+// Not thread safe, writes must all come from one thread, the counters are atomics so other threads can read them for display
+class GpioShadow
+{
+private:
+    uint64_t knownLevels = 0; // JET_PIN bits of the pins whose level is in levels
+    uint64_t levels = 0;
+    int duties[GPIO_SHADOW_PINS]; // Last duty cycle per pin, -1 if unknown
+    uint64_t configuredPwm = 0;   // JET_PIN bits of the pins gpioPWMConfigure set up
+
+    std::atomic<unsigned long> performed{0}; // Pin writes that went to the registers
+    std::atomic<unsigned long> skipped{0};   // Pin writes dropped because the pin already had that level or duty
+
+    // Counters only change on the writing thread, so plain load/store is enough
+    static void add(std::atomic<unsigned long> &counter, unsigned long count)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+public:
+    GpioShadow()
+    {
+        invalidate();
+    }
+
+    // Forgets every pin, the next write to each one goes to the registers
+    void invalidate()
+    {
+        knownLevels = 0;
+        levels = 0;
+        configuredPwm = 0;
+        for (int i = 0; i < GPIO_SHADOW_PINS; i++)
+            duties[i] = -1;
+    }
+
+    // gpioWriteMask that only writes the pins whose level changes
+    // Returns what gpioWriteMask returns, or 1 if no pin had to change
+    int writeMask(uint64_t pins, uint64_t pinLevels)
+    {
+        const uint64_t unchanged = pins & knownLevels & ~(levels ^ pinLevels);
+        const uint64_t changed = pins & ~unchanged;
+        add(skipped, __builtin_popcountll(unchanged));
+        if (changed == 0)
+            return 1;
+
+        int result = gpioWriteMask(changed, pinLevels);
+        if (result < 0)
+            return result; // Nothing was written
+
+        add(performed, __builtin_popcountll(changed));
+        knownLevels |= changed;
+        levels = (levels & ~changed) | (pinLevels & changed);
+        return result;
+    }
+
+    // gpioWrite that skips the write if <gpio> is already at <level>
+    int write(unsigned gpio, unsigned level)
+    {
+        if (gpio >= GPIO_SHADOW_PINS || level > 1)
+            return gpioWrite(gpio, level); // Let jetgpio report the bad argument
+        return writeMask(JET_PIN(gpio), level ? JET_PIN(gpio) : 0);
+    }
+
+    // gpioPWM that skips the write if <gpio> already runs at <dutyCycle>
+    // The first write routes the pin to its PWM controller, the later ones only store the duty cycle (gpioPWMDuty)
+    int pwm(unsigned gpio, unsigned dutyCycle)
+    {
+        if (gpio >= GPIO_SHADOW_PINS)
+            return gpioPWM(gpio, dutyCycle); // Let jetgpio report the bad pin
+
+        if (duties[gpio] == (int)dutyCycle)
+        {
+            add(skipped, 1);
+            return 1;
+        }
+
+        if (!(configuredPwm & JET_PIN(gpio)))
+        {
+            int result = gpioPWMConfigure(gpio);
+            if (result < 0)
+                return result;
+            configuredPwm |= JET_PIN(gpio);
+        }
+
+        int result = gpioPWMDuty(gpio, dutyCycle);
+        if (result >= 0)
+        {
+            add(performed, 1);
+            duties[gpio] = dutyCycle;
+        }
+        return result;
+    }
+
+    // gpioSetPWMfrequency, which also clears the duty cycle so the pin's next pwm call is always written
+    int setPWMFrequency(unsigned gpio, unsigned frequency)
+    {
+        if (gpio < GPIO_SHADOW_PINS)
+            duties[gpio] = -1;
+        return gpioSetPWMfrequency(gpio, frequency);
+    }
+
+    unsigned long getPerformed() const { return performed.load(std::memory_order_relaxed); }
+    unsigned long getSkipped() const { return skipped.load(std::memory_order_relaxed); }
+};
+
+// Shadow of the Jetson's header pins, shared by everything that drives them
+inline GpioShadow &gpioShadow()
+{
+    static GpioShadow shadow;
+    return shadow;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "spsc.hpp"
+
+#define LOG_QUEUE_SIZE 256   // Lines that can wait for the writer thread
+#define LOG_LINE_LENGTH 128  // Longest line in bytes (including the newline), longer lines are cut off
+#define LOG_FLUSH_INTERVAL 50 // Milliseconds between writer thread flushes
+
+// Non-blocking logger for the control path
+// log() formats into a fixed size slot of a ring buffer and returns, a background thread writes the lines out
+// in batches. If the writer falls behind, new lines are dropped and counted instead of blocking the caller.
+// Only one thread may call log()
+class AsyncLog
+{
+private:
+    struct Line
+    {
+        unsigned short length;
+        char text[LOG_LINE_LENGTH];
+    };
+
+    SpscRing<Line, LOG_QUEUE_SIZE> queue;
+    int fd; // File descriptor the lines are written to
+
+    std::thread writer;
+    std::atomic<bool> running{true};
+    std::atomic<unsigned long> dropped{0};
+
+    // Writes everything queued with as few write() calls as possible
+    void flush(std::string &batch)
+    {
+        Line line;
+        batch.clear();
+        while (queue.pop(line))
+        {
+            batch.append(line.text, line.length);
+        }
+
+        unsigned long lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost > 0)
+        {
+            batch += "(" + std::to_string(lost) + " log lines dropped)\n";
+        }
+
+        std::size_t written = 0;
+        while (written < batch.size())
+        {
+            ssize_t result = ::write(fd, batch.data() + written, batch.size() - written);
+            if (result <= 0)
+                break;
+            written += result;
+        }
+    }
+
+    void run()
+    {
+        std::string batch;
+        batch.reserve(LOG_QUEUE_SIZE * LOG_LINE_LENGTH);
+        while (running.load(std::memory_order_acquire))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOG_FLUSH_INTERVAL));
+            flush(batch);
+        }
+        flush(batch);
+    }
+
+public:
+    AsyncLog(int fd = STDERR_FILENO) : fd(fd)
+    {
+        writer = std::thread(&AsyncLog::run, this);
+    }
+
+    ~AsyncLog()
+    {
+        running.store(false, std::memory_order_release);
+        writer.join();
+    }
+
+    // printf style, a newline is added to every line
+    void log(const char *format, ...)
+    {
+        Line line;
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(line.text, LOG_LINE_LENGTH - 1, format, args);
+        va_end(args);
+
+        if (length < 0)
+            return;
+        if (length > LOG_LINE_LENGTH - 2)
+            length = LOG_LINE_LENGTH - 2;
+        line.text[length] = '\n';
+        line.length = length + 1;
+
+        if (!queue.push(line))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Log shared by the servers for per-packet and connection messages, written to stderr
+// Call it from the network thread only
+inline AsyncLog &packetLog()
+{
+    static AsyncLog log;
+    return log;
+}
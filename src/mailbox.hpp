@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+
+// Single slot that only keeps the newest value posted to it
+// Posting over a value that was never taken replaces it and counts it as skipped
+// Not thread safe, post and take from the same thread, only the counters can be read from other threads
+template <typename T>
+class Mailbox
+{
+private:
+    T value;
+    bool full = false;
+
+    std::atomic<unsigned long> posted{0};  // Number of values ever posted
+    std::atomic<unsigned long> skipped{0}; // Number of values replaced before anyone took them
+
+    // Counters only change on the posting thread, so plain load/store is enough
+    static void increment(std::atomic<unsigned long> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+public:
+    // Store <newValue>, replacing the pending value if there is one
+    void post(const T &newValue)
+    {
+        if (full)
+        {
+            increment(skipped);
+        }
+        value = newValue;
+        full = true;
+        increment(posted);
+    }
+
+    // Move the pending value into <out>, returns false if there was nothing pending
+    bool take(T &out)
+    {
+        if (!full)
+        {
+            return false;
+        }
+        out = value;
+        full = false;
+        return true;
+    }
+
+    // Drop the pending value without counting it as skipped
+    void clear()
+    {
+        full = false;
+    }
+
+    bool hasValue() const
+    {
+        return full;
+    }
+
+    unsigned long getPosted() const
+    {
+        return posted.load(std::memory_order_relaxed);
+    }
+
+    unsigned long getSkipped() const
+    {
+        return skipped.load(std::memory_order_relaxed);
+    }
+};
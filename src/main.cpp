@@ -1,5 +1,10 @@
 #include "motor.hpp"
 #include "server.hpp"
+#include "actuation.hpp"
+#include "dashboard.hpp"
+#include "enetpool.hpp"
+#include "log.hpp"
+#include "trace.hpp"
 #include "types.hpp"
 
 #include <iostream>
@@ -7,47 +12,166 @@
 #include <bitset>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #define VERSION "0.0.8"
 
 MotorInterface *motors = getMotorContoller();
 UDPServerHandler serverHandler;
 
-void onMotionUpdate(MotionPacketData data, ServerHandler *serverHandler)
+// Runs on the actuation thread
+void applyMotion(const MotionCommand &motion)
 {
-    system("clear");
-    std::cout << "Version: " << VERSION << std::endl;
-    for (std::bitset<8> bitset : data.rawBinary)
+    motors->setDrivePercent(motion.leftDrivePercent * 0.25, motion.rightDrivePercent * 0.25);
+    motors->setActuators(motion.actuator1, motion.actuator2);
+}
+
+// Runs on the actuation thread, macros aren't implemented yet so they don't move anything
+void applyMacro(const MacroCommand &)
+{
+}
+
+// Runs on the actuation thread, reset all robot motion to 0
+void applyStop()
+{
+    motors->stopMovement();
+}
+
+ActuationThread actuation(applyMotion, applyMacro, applyStop);
+
+// Everything the dashboard shows about the latest motion packet
+struct MotionState
+{
+    MotionCommand motion;
+    uint8_t raw[MAX_MOTION_PACKET_LENGTH];
+    std::size_t rawLength;
+    unsigned long packets;
+};
+
+// Runs on the dashboard thread
+void renderDashboard(const MotionState &state, std::ostream &out)
+{
+    out << "Version: " << VERSION << "\n";
+    for (std::size_t i = 0; i < state.rawLength; i++)
+    {
+        out << std::bitset<8>(state.raw[i]) << " ";
+    }
+    out << "\n";
+    out << "Left:\t" << state.motion.leftDrivePercent << "%\n";
+    out << "Right:\t" << state.motion.rightDrivePercent << "%\n";
+    out << "Actuator 1:\t" << state.motion.actuator1 << "\n";
+    out << "Actuator 2:\t" << state.motion.actuator2 << "\n";
+
+    ActuationStats stats = actuation.getStats();
+    out << "\n";
+    out << "Motion packets:\t" << state.packets << " (" << serverHandler.getSkippedMotionUpdates() << " skipped, " << serverHandler.getStaleMotionPackets() << " out of order)\n";
+    out << "Fast motion:\t" << serverHandler.getFastMotionPackets() << " (" << serverHandler.getRejectedFastMotion() << " rejected)\n";
+    out << "Bad checksums:\t" << serverHandler.getChecksumFailures() << "\n";
+    LinkQuality link = serverHandler.getMotionLinkQuality();
+    if (link.samples > 0)
+        out << "Link:\t\t" << link.roundTripMicros << " us rtt (+/- " << link.roundTripVarianceMicros << "), " << link.jitterMicros << " us jitter, " << link.packetLoss * 100 << "% loss\n";
+    out << "GPIO writes:\t" << gpioShadow().getPerformed() << " (" << gpioShadow().getSkipped() << " unchanged, skipped)\n";
+    out << "Actuation:\t" << stats.applied << " applied, " << stats.coalesced << " coalesced\n";
+    out << "ENet pools:\t";
+    for (int i = 0; i < EnetPool::CLASS_COUNT; i++)
     {
-        std::cout << bitset << " ";
+        const SlabPool &pool = EnetPool::pools()[i];
+        out << pool.name << " " << pool.getHighWater() << "/" << pool.getCapacity() << (pool.getOverflows() > 0 ? "!" : "") << "  ";
     }
-    std::cout << std::endl;
-    std::cout << "Left:\t" << data.leftDrivePercent << "%" << std::endl;
-    std::cout << "Right:\t" << data.rightDrivePercent << "%" << std::endl;
-    std::cout << "Actuator 1:\t" << data.actuator1 << std::endl;
-    std::cout << "Actuator 2:\t" << data.actuator2 << std::endl;
+    out << "(" << EnetPool::heapAllocations().load(std::memory_order_relaxed) << " malloc)\n";
+    out << "Queue:\t\t" << stats.queueDepth << " (max " << stats.maxQueueDepth << ")\n";
+    out << "Latency:\t" << stats.meanLatencyNs / 1000 << " us mean, " << stats.maxLatencyNs / 1000 << " us max\n";
+    out << "Ticks:\t\t" << stats.ticks << " (" << stats.overruns << " overruns, " << stats.meanJitterNs / 1000 << " us mean jitter)\n";
+#ifdef LATENCY_TRACE
+    out << "\n";
+    LatencyTrace::dump(out);
+#endif
+}
+
+Dashboard<MotionState> dashboard(renderDashboard);
+MotionState motionState = {};
+
+void onMotionUpdate(const MotionPacketData &data, ServerHandler *serverHandler)
+{
+    actuation.submitMotion(data);
 
-    motors->setDrivePercent(data.leftDrivePercent * 0.25, data.rightDrivePercent * 0.25);
-    motors->setActuators(data.actuator1, data.actuator2);
+    motionState.motion = data;
+    motionState.rawLength = std::min(data.length, MAX_MOTION_PACKET_LENGTH);
+    std::memcpy(motionState.raw, data.bytes, motionState.rawLength);
+    motionState.packets++;
+    dashboard.publish(motionState);
 }
 
-void onMacro(MacroPacketData data, ServerHandler *serverHandler)
+void onMacro(const MacroPacketData &data, ServerHandler *serverHandler)
 {
-    // TODO: implement macro handling
+    actuation.submitMacro(data);
 }
 
-// Reset all robot motion to 0
 void onDisconnect(ServerHandler *serverHandler)
 {
-    motors->stopMovement();
-    std::cout << "All actions stopped for now..." << std::endl;
+    actuation.submitStop();
+    packetLog().log("All actions stopped for now...");
+}
+
+// Reads the fast motion key from the MOTION_KEY environment variable (32 hex digits)
+// Returns false if it isn't set or isn't a valid key
+bool readFastMotionKey(uint8_t *key)
+{
+    const char *hex = std::getenv("MOTION_KEY");
+    if (hex == nullptr || std::strlen(hex) != FastMotion::KEY_LENGTH * 2)
+        return false;
+
+    for (std::size_t i = 0; i < FastMotion::KEY_LENGTH; i++)
+    {
+        unsigned int byte;
+        if (std::sscanf(hex + i * 2, "%2x", &byte) != 1)
+            return false;
+        key[i] = byte;
+    }
+    return true;
 }
 
-int main()
+// Usage: main [control loop rate in Hz, 0 to apply packets as they arrive]
+// Set MOTION_KEY to accept fast motion datagrams signed with it
+// Set ENET_CHECKSUM=1 to checksum every ENet datagram, clients must set it too
+// Set ENET_COMPRESS=lz or ENET_COMPRESS=range to compress ENet datagrams, clients must use the same compressor
+int main(int argc, char **argv)
 {
-    serverHandler.setMotionUpdateCallback(onMotionUpdate);
-    serverHandler.setMacroCallback(onMacro);
-    serverHandler.setDisconnectCallback(onDisconnect);
+    unsigned int controlRate = argc > 1 ? std::stoul(argv[1]) : PWM_FREQUENCY;
+
+    uint8_t motionKey[FastMotion::KEY_LENGTH];
+    if (readFastMotionKey(motionKey))
+    {
+        serverHandler.enableFastMotion(motionKey);
+    }
+
+    const char *checksum = std::getenv("ENET_CHECKSUM");
+    if (checksum != nullptr && std::strcmp(checksum, "1") == 0)
+    {
+        serverHandler.enableChecksum();
+    }
+
+    const char *compressor = std::getenv("ENET_COMPRESS");
+    if (compressor != nullptr && !serverHandler.enableCompression(compressor))
+    {
+        std::cout << "Unknown ENET_COMPRESS compressor " << compressor << ", use lz or range\n";
+        return EXIT_FAILURE;
+    }
+
+    serverHandler.setMotionUpdateHandler(onMotionUpdate);
+    serverHandler.setMacroHandler(onMacro);
+    serverHandler.setDisconnectHandler(onDisconnect);
+
+    actuation.start(controlRate);
+
+    // Log lines written to the same terminal would tear the dashboard's redraws
+    if (sameTerminal(STDOUT_FILENO, STDERR_FILENO))
+        std::cout << "The status dashboard is off because stderr shares its terminal, run with 2> packets.log to see it\n";
+    else
+        dashboard.start();
 
     serverHandler.run();
 
@@ -6,6 +6,8 @@
 #include <string>
 #include <thread>
 #include "types.hpp"
+#include "trace.hpp"
+#include "gpioshadow.hpp"
 
 #define NUM_ACTUATORS 2
 
@@ -21,28 +23,29 @@
 #define LIM_SWITCH_2_CON_PIN 26 // Front actuator extended position limit switch signal (1: stop) - input pin to jetson
 #define RELAY_PIN 24
 
+#define PWM_FREQUENCY 150 // Frequency in Hz to run the drive motor PWM at
+
 class PWMDriveMotor
 {
 private:
-    static const int FREQUENCY = 150;                           // Frequency in Hz to run the PWM at
+    static const int FREQUENCY = PWM_FREQUENCY;                 // Frequency in Hz to run the PWM at
     static const int STOP_PWM = 0.0015 * FREQUENCY * 256;       // Pulse width of the PWM value to stop the drive motors
     static const int NUM_PARTITIONS = 0.0005 * FREQUENCY * 256; // Difference between STOP_PWM_VALUE and full fowards and full backwards PWM values
     int pwmPinNum;                                              // The pin number controlling the a PWM motor
-    int prevPercent = 0;                                        // Previous PWM value
 
 public:
     PWMDriveMotor(int pin)
     {
         pwmPinNum = pin;
 
-        int errorCode = gpioSetPWMfrequency(pwmPinNum, FREQUENCY);
+        int errorCode = gpioShadow().setPWMFrequency(pwmPinNum, FREQUENCY);
         if (errorCode < 0)
         {
             printf("Failed to create drive motor obj, Error code: %d\n", errorCode);
             return;
         }
 
-        errorCode = gpioPWM(pwmPinNum, STOP_PWM);
+        errorCode = gpioShadow().pwm(pwmPinNum, STOP_PWM);
         if (errorCode < 0)
         {
             printf("Failed to set drive motor PWM, Error code: %d\n", errorCode);
@@ -52,7 +55,7 @@ public:
 
     ~PWMDriveMotor()
     {
-        int errorCode = gpioPWM(pwmPinNum, STOP_PWM);
+        int errorCode = gpioShadow().pwm(pwmPinNum, STOP_PWM);
         if (errorCode < 0)
         {
             printf("Failed to set drive motor PWM, Error code: %d\n", errorCode);
@@ -72,17 +75,10 @@ public:
             percent = -100;
         }
 
-        // If the percent equals the previous one, then return to reduce stuttering
-        if (percent == prevPercent)
-        {
-            return;
-        }
-
-        prevPercent = percent;
-
+        // The shadow skips the write if the duty cycle didn't change, rewriting it would make the motor stutter
         int percentToPWM = percent * NUM_PARTITIONS / 100;
         int dutyCycle = STOP_PWM + percentToPWM;
-        int errorCode = gpioPWM(pwmPinNum, dutyCycle);
+        int errorCode = gpioShadow().pwm(pwmPinNum, dutyCycle);
         if (errorCode < 0)
         {
             printf("Failed to set drive motor PWM, Error code: %d\n", errorCode);
@@ -99,9 +95,6 @@ private:
     int switchExtendPin;  // Limit switch extended logic pin input
     int switchRetractPin; // Limit switch retrated logic pin input
 
-    int prevA = 0; // Previous pin A value
-    int prevB = 0; // Previous pin B value
-
 public:
     Actuator(int desiredPinA, int desiredPinB)
     {
@@ -124,26 +117,38 @@ public:
     {
     }
 
+    // Mask of the actuator's pins for gpioWriteMask
+    uint64_t getPins() const
+    {
+        return JET_PIN(pinA) | JET_PIN(pinB);
+    }
+
+    // Levels of the actuator's pins for <motion>, for gpioWriteMask with getPins
+    uint64_t getLevels(ActuatorMotion motion) const
+    {
+        if (motion == ActuatorMotion::EXTENDING)
+            return JET_PIN(pinA);
+        else if (motion == ActuatorMotion::RETRACTING)
+            return JET_PIN(pinB);
+        else
+            return JET_PIN(pinA) | JET_PIN(pinB);
+    }
+
     // Set the actuator to extend, returns true if it can, false if it cannot
     bool extend()
     {
-        int e1 = gpioWrite(pinA, 1);
-        int e2 = gpioWrite(pinB, 0);
-        return e1 == 0 && e2 == 0;
+        return gpioShadow().writeMask(getPins(), getLevels(ActuatorMotion::EXTENDING)) >= 0;
     }
 
     // Set the actuator to retract, returns true if it can, false if it cannot
     bool retract()
     {
-        int e1 = gpioWrite(pinA, 0);
-        int e2 = gpioWrite(pinB, 1);
-        return e1 == 0 && e2 == 0;
+        return gpioShadow().writeMask(getPins(), getLevels(ActuatorMotion::RETRACTING)) >= 0;
     }
 
     void stopMovement()
     {
-        gpioWrite(pinA, 1);
-        gpioWrite(pinB, 1);
+        gpioShadow().writeMask(getPins(), getLevels(ActuatorMotion::NONE));
     }
 
     // Set the motion for the actuator, returns true if it can, false if it cannot
@@ -205,6 +210,16 @@ public:
 class MotorController : public MotorInterface
 {
 private:
+    // Terminates jetgpio when the controller is destroyed, declared first so it runs after the motors have stopped
+    struct GpioSession
+    {
+        ~GpioSession()
+        {
+            gpioTerminate();
+            gpioShadow().invalidate(); // gpioTerminate put the registers back the way they were
+        }
+    } gpioSession;
+
     PWMDriveMotor leftDrive;
     PWMDriveMotor rightDrive;
     Actuator actuators[NUM_ACTUATORS];
@@ -221,11 +236,6 @@ public:
     {
     }
 
-    ~MotorController()
-    {
-        gpioTerminate();
-    }
-
     PWMDriveMotor *getLeftDrive()
     {
         return &leftDrive;
@@ -254,6 +264,7 @@ public:
     // Sets the drive wheel percents [-100, 100] for the left and right wheel
     bool setDrivePercent(int leftPercent, int rightPercent)
     {
+        TRACE_MARK(SET_DRIVE);
         if (disableDriveMotors)
         {
             return false;
@@ -262,6 +273,7 @@ public:
         {
             leftDrive.setPercent(leftPercent);
             rightDrive.setPercent(rightPercent);
+            TRACE_MARK(PWM_WRITE);
             return true;
         }
     }
@@ -275,8 +287,10 @@ public:
         }
         else
         {
-            actuators[0].setMotion(a1);
-            actuators[1].setMotion(a2);
+            // Both actuators in one call, pins sharing a port change in the same register write and pins already
+            // in the right state aren't written at all
+            gpioShadow().writeMask(actuators[0].getPins() | actuators[1].getPins(), actuators[0].getLevels(a1) | actuators[1].getLevels(a2));
+            TRACE_MARK(GPIO_WRITE);
             return true;
         }
     }
@@ -289,15 +303,13 @@ public:
         }
         else
         {
-            bool success = true;
+            uint64_t pins = 0, levels = 0;
             for (int i = 0; i < NUM_ACTUATORS; i++)
             {
-                if (!actuators[i].setMotion(motions[i]))
-                {
-                    success = false;
-                }
+                pins |= actuators[i].getPins();
+                levels |= actuators[i].getLevels(motions[i]);
             }
-            return success;
+            return gpioShadow().writeMask(pins, levels) >= 0;
         }
     }
 
@@ -415,13 +427,17 @@ int initJetGpio()
 {
     int initError = gpioInitialise();
 
-    if (initError != 0)
+    // gpioInitialise returns 1 when it succeeds
+    if (initError < 0)
     {
         printf("Jetgpio initialisation failed. Error code %d\n", initError);
     }
     else
     {
         printf("Jetgpio initialisation OK. Return code: %d\n", initError);
+#ifdef JETGPIO_SIMULATED
+        printf("Jetgpio registers are simulated, no pins will change\n");
+#endif
     }
 
     return initError;
@@ -431,7 +447,7 @@ MotorInterface *getMotorContoller()
 {
     int error = initJetGpio();
 
-    if (error != 0)
+    if (error < 0)
     {
         return new SimulatedMotorController();
     }
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "types.hpp"
+
+// Enumeration to represent the different macros at their macroCode
+enum Macro
+{
+    ESTOP,
+    CANCEL_MACRO,
+    FULL_EXTEND,
+    FULL_RETRACT,
+    CARRY_POS,
+    DUMP_CYCLE,
+    DUMP_WITH_MOVEMENT,
+    DIG_CYCLE,
+    TURN_RIGHT_45,
+    TURN_LEFT_45,
+    TURN
+};
+
+// What a received buffer was decoded as
+enum class PacketType
+{
+    INVALID,
+    MOTION,
+    MACRO
+};
+
+// Plain decoded contents of a motion packet (no heap members, safe to copy around)
+struct MotionCommand
+{
+    int leftDrivePercent;
+    int rightDrivePercent;
+    ActuatorMotion actuator1;
+    ActuatorMotion actuator2;
+};
+
+// Plain decoded contents of a macro packet (no heap members, safe to copy around)
+struct MacroCommand
+{
+    Macro macro;
+    bool pressed;
+    unsigned int data;
+};
+
+// Returns what ActuatorMotion enum item is the case based on the a and b booleans
+// a | b | motion
+// --|---|-------
+// 0 | 0 | NONE
+// 0 | 1 | RETRACTING
+// 1 | 0 | EXTENDING
+// 1 | 1 | NONE
+constexpr ActuatorMotion getActuatorMotion(bool a, bool b)
+{
+    if (a == b)
+        return ActuatorMotion::NONE;
+    else if (!a && b)
+        return ActuatorMotion::RETRACTING;
+    else
+        return ActuatorMotion::EXTENDING;
+}
+
+// Longest motion packet in bytes (2 bytes of motion followed by an optional 2 byte sequence number)
+constexpr std::size_t MAX_MOTION_PACKET_LENGTH = 4;
+
+// Returns true if the buffer is a motion packet (2 or 4 bytes and first bit is 0)
+inline bool isMotionPacket(const uint8_t *bytes, std::size_t length)
+{
+    return (length == 2 || length == MAX_MOTION_PACKET_LENGTH) && !(bytes[0] & 0b10000000);
+}
+
+// Reads the sequence number of a 4 byte motion packet (big endian bytes 3 and 4)
+// Returns false for 2 byte motion packets, which have none
+inline bool getMotionSequence(const uint8_t *bytes, std::size_t length, uint16_t &sequence)
+{
+    if (length != MAX_MOTION_PACKET_LENGTH)
+        return false;
+    sequence = (uint16_t)(bytes[2] << 8 | bytes[3]);
+    return true;
+}
+
+// Writes <sequence> into bytes 3 and 4 of a motion packet buffer, making it a 4 byte motion packet
+inline void setMotionSequence(uint8_t *bytes, uint16_t sequence)
+{
+    bytes[2] = sequence >> 8;
+    bytes[3] = sequence & 0xFF;
+}
+
+// Returns true if <sequence> was sent after <previous>, wrapping around after 65535
+inline bool isNewerSequence(uint16_t sequence, uint16_t previous)
+{
+    return (int16_t)(uint16_t)(sequence - previous) > 0;
+}
+
+// Returns true if the buffer is a macro packet (1 or 2 bytes and first bit is 1)
+inline bool isMacroPacket(const uint8_t *bytes, std::size_t length)
+{
+    return (length == 1 || length == 2) && (bytes[0] & 0b10000000);
+}
+
+// Bit layout of a motion packet, documented in macros.md
+// The decode tables below are generated from these values only, so change the layout here and nowhere else
+namespace MotionLayout
+{
+    // byte 0
+    constexpr uint8_t LEFT_BUMPER = 0b01000000;   // Retract actuator 1
+    constexpr uint8_t RIGHT_BUMPER = 0b00100000;  // Retract actuator 2
+    constexpr uint8_t LEFT_TRIGGER = 0b00010000;  // Extend actuator 1
+    constexpr uint8_t RIGHT_TRIGGER = 0b00001000; // Extend actuator 2
+
+    // byte 1
+    constexpr uint8_t LEFT_SIGN = 0b10000000;
+    constexpr uint8_t LEFT_MAGNITUDE = 0b01110000;
+    constexpr unsigned LEFT_SHIFT = 4;
+    constexpr uint8_t RIGHT_SIGN = 0b00001000;
+    constexpr uint8_t RIGHT_MAGNITUDE = 0b00000111;
+    constexpr unsigned RIGHT_SHIFT = 0;
+
+    // Drive percent per magnitude step, truncated towards 0 like the original int *= 14.28
+    constexpr double PERCENT_PER_STEP = 14.28;
+}
+
+// Left and right drive percents for one value of motion byte 1
+struct DriveEntry
+{
+    int8_t left;
+    int8_t right;
+};
+
+// Actuator motions for one value of motion byte 0
+struct ActuatorEntry
+{
+    uint8_t actuator1;
+    uint8_t actuator2;
+};
+
+// Signed drive percent of one wheel encoded in <byte>
+constexpr int8_t drivePercent(uint8_t byte, uint8_t signMask, uint8_t magnitudeMask, unsigned shift)
+{
+    int magnitude = (byte & magnitudeMask) >> shift;
+    int percent = (int)(magnitude * MotionLayout::PERCENT_PER_STEP);
+    return (int8_t)((byte & signMask) ? -percent : percent);
+}
+
+constexpr std::array<DriveEntry, 256> makeDriveTable()
+{
+    std::array<DriveEntry, 256> table{};
+    for (unsigned byte = 0; byte < 256; byte++)
+    {
+        table[byte].left = drivePercent(byte, MotionLayout::LEFT_SIGN, MotionLayout::LEFT_MAGNITUDE, MotionLayout::LEFT_SHIFT);
+        table[byte].right = drivePercent(byte, MotionLayout::RIGHT_SIGN, MotionLayout::RIGHT_MAGNITUDE, MotionLayout::RIGHT_SHIFT);
+    }
+    return table;
+}
+
+constexpr std::array<ActuatorEntry, 256> makeActuatorTable()
+{
+    std::array<ActuatorEntry, 256> table{};
+    for (unsigned byte = 0; byte < 256; byte++)
+    {
+        table[byte].actuator1 = getActuatorMotion(byte & MotionLayout::LEFT_TRIGGER, byte & MotionLayout::LEFT_BUMPER);
+        table[byte].actuator2 = getActuatorMotion(byte & MotionLayout::RIGHT_TRIGGER, byte & MotionLayout::RIGHT_BUMPER);
+    }
+    return table;
+}
+
+// Motion byte 1 -> drive percents and motion byte 0 -> actuator motions, built at compile time
+constexpr std::array<DriveEntry, 256> DRIVE_TABLE = makeDriveTable();
+constexpr std::array<ActuatorEntry, 256> ACTUATOR_TABLE = makeActuatorTable();
+
+// Spot checks against the layout described in macros.md
+static_assert(DRIVE_TABLE[0b01110111].left == 99 && DRIVE_TABLE[0b01110111].right == 99, "full forwards is 99%");
+static_assert(DRIVE_TABLE[0b11111111].left == -99 && DRIVE_TABLE[0b11111111].right == -99, "full backwards is -99%");
+static_assert(DRIVE_TABLE[0b10110011].left == -42 && DRIVE_TABLE[0b10110011].right == 42, "magnitude 3 is 42%");
+static_assert(ACTUATOR_TABLE[0b00010000].actuator1 == EXTENDING && ACTUATOR_TABLE[0b01000000].actuator1 == RETRACTING, "actuator 1 uses the left trigger and bumper");
+static_assert(ACTUATOR_TABLE[0b00001000].actuator2 == EXTENDING && ACTUATOR_TABLE[0b00101000].actuator2 == NONE, "actuator 2 uses the right trigger and bumper");
+
+// Decodes a motion packet (manual control of motors & actuators), bytes must point to at least 2 bytes
+// Two table loads, no branches or floating point
+inline void decodeMotion(const uint8_t *bytes, MotionCommand &motion)
+{
+    const ActuatorEntry &actuators = ACTUATOR_TABLE[bytes[0]];
+    const DriveEntry &drive = DRIVE_TABLE[bytes[1]];
+
+    motion.leftDrivePercent = drive.left;
+    motion.rightDrivePercent = drive.right;
+    motion.actuator1 = ActuatorMotion(actuators.actuator1);
+    motion.actuator2 = ActuatorMotion(actuators.actuator2);
+}
+
+// Decodes a macro packet (preprogrammed action to happen once), bytes must point to <length> (1 or 2) bytes
+inline void decodeMacro(const uint8_t *bytes, std::size_t length, MacroCommand &macro)
+{
+    unsigned int macroCode = (bytes[0] & 0b01111100) >> 2; // 0 < macroCode < 23; code representing macro to execute
+
+    macro.macro = Macro(macroCode);
+    macro.pressed = bytes[0] & 0b00000010; // Boolean representing if the button was pressed down
+    macro.data = length == 2 ? bytes[1] : 0;
+}
+
+// Decodes a raw packet into whichever of the caller-owned structs matches its type
+// Stateless and allocation free, only the struct matching the returned type is written
+inline PacketType decodePacket(const uint8_t *bytes, std::size_t length, MotionCommand &motion, MacroCommand &macro)
+{
+    if (isMotionPacket(bytes, length))
+    {
+        decodeMotion(bytes, motion);
+        return PacketType::MOTION;
+    }
+    else if (isMacroPacket(bytes, length))
+    {
+        decodeMacro(bytes, length, macro);
+        return PacketType::MACRO;
+    }
+
+    return PacketType::INVALID;
+}
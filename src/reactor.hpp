@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "callback.hpp"
+
+#define REACTOR_MAX_EVENTS 16 // File descriptor events handled per epoll_wait
+
+// Single threaded epoll event loop
+// Every I/O source (the ENet socket, timerfds) is a file descriptor watched here, so one thread blocks in one place
+// and wakes exactly when something is ready instead of polling each source
+class Reactor
+{
+public:
+    // Called with the ready file descriptor and its epoll events
+    typedef InplaceFunction<void(int, uint32_t)> Handler;
+
+private:
+    struct Watch
+    {
+        Handler handler;
+        bool timer;   // Expirations are read off the timerfd before the handler runs
+        bool removed; // Unwatched while events were being dispatched, erased afterwards
+    };
+
+    int epollFd;
+    bool running = false;
+    bool dispatching = false;
+    std::unordered_map<int, Watch> watches;
+    std::vector<int> removedFds;
+
+public:
+    Reactor()
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    ~Reactor()
+    {
+        for (auto &watch : watches)
+        {
+            if (watch.second.timer)
+                close(watch.first);
+        }
+        close(epollFd);
+    }
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    // Calls <handler> whenever <fd> has any of <events> (EPOLLIN, EPOLLOUT, ...), returns false on failure
+    bool watch(int fd, uint32_t events, Handler handler, bool timer = false)
+    {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+            return false;
+
+        Watch &entry = watches[fd];
+        entry.handler = std::move(handler);
+        entry.timer = timer;
+        entry.removed = false;
+        return true;
+    }
+
+    // Stops watching <fd>, safe to call from inside a handler
+    void unwatch(int fd)
+    {
+        auto found = watches.find(fd);
+        if (found == watches.end())
+            return;
+
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        if (found->second.timer)
+            close(fd);
+
+        if (dispatching)
+        {
+            found->second.removed = true;
+            removedFds.push_back(fd);
+        }
+        else
+        {
+            watches.erase(found);
+        }
+    }
+
+    // Creates a disarmed timer that calls <handler> when it expires, returns its timerfd or -1 on failure
+    int addTimer(Handler handler)
+    {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0)
+            return -1;
+        if (!watch(fd, EPOLLIN, std::move(handler), true))
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // (Re)arms a timer to expire once after <delayNs>, then every <periodNs> if that isn't 0
+    // A delay of 0 disarms the timer
+    static void armTimer(int timerFd, int64_t delayNs, int64_t periodNs = 0)
+    {
+        itimerspec spec = {};
+        spec.it_value.tv_sec = delayNs / 1000000000;
+        spec.it_value.tv_nsec = delayNs % 1000000000;
+        spec.it_interval.tv_sec = periodNs / 1000000000;
+        spec.it_interval.tv_nsec = periodNs % 1000000000;
+        timerfd_settime(timerFd, 0, &spec, nullptr);
+    }
+
+    // Waits up to <timeoutMs> (-1 forever) and runs the handlers of everything that became ready
+    // Returns the number of ready file descriptors, or -1 on error
+    int runOnce(int timeoutMs = -1)
+    {
+        epoll_event events[REACTOR_MAX_EVENTS];
+        int count = epoll_wait(epollFd, events, REACTOR_MAX_EVENTS, timeoutMs);
+        if (count < 0)
+            return errno == EINTR ? 0 : -1;
+
+        dispatching = true;
+        for (int i = 0; i < count; i++)
+        {
+            auto found = watches.find(events[i].data.fd);
+            if (found == watches.end() || found->second.removed)
+                continue;
+
+            if (found->second.timer)
+            {
+                uint64_t expirations;
+                if (read(found->first, &expirations, sizeof(expirations)) != sizeof(expirations))
+                    continue;
+            }
+
+            found->second.handler(found->first, events[i].events);
+        }
+        dispatching = false;
+
+        for (int fd : removedFds)
+        {
+            watches.erase(fd);
+        }
+        removedFds.clear();
+
+        return count;
+    }
+
+    // Runs handlers until stop is called (from a handler) or epoll fails
+    void run()
+    {
+        running = true;
+        while (running && runOnce() >= 0)
+        {
+        }
+    }
+
+    void stop()
+    {
+        running = false;
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Holds the latest copy of a small plain struct
+// One writer stores without ever blocking, any number of readers copy it out and retry if a store raced them
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock can only hold trivially copyable types");
+
+private:
+    std::atomic<unsigned long> sequence{0}; // Odd while a store is in progress
+    T value{};
+
+public:
+    // Replace the stored value (single writer thread only)
+    void store(const T &newValue)
+    {
+        unsigned long seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy((void *)&value, &newValue, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copy out a consistent version of the stored value
+    T load() const
+    {
+        T copy;
+        unsigned long before, after;
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            std::memcpy(&copy, (const void *)&value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return copy;
+    }
+
+    // Number of stores so far
+    unsigned long version() const
+    {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
@@ -2,59 +2,76 @@
 
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
+#include <atomic>
 #include <iostream>
 #include <bitset>
+#include <cstring>
 #include <string>
 #include <functional>
 #include <vector>
 
 #include "types.hpp"
+#include "packet.hpp"
+#include "fastmotion.hpp"
+#include "callback.hpp"
+#include "mailbox.hpp"
+#include "log.hpp"
+#include "reactor.hpp"
+#include "seqlock.hpp"
+#include "enetpool.hpp"
+#include "trace.hpp"
 #include <enet/enet.h>
+#include <enet/time.h>
 
 #define DEFAULT_PORT 9002
 
+// UDP channel policy, a channel only blocks on retransmits of its own packets
+#define MOTION_CHANNEL 0  // Motion packets, sent unsequenced so a lost one never holds up the newer ones behind it
+#define CONTROL_CHANNEL 1 // Macros (including ESTOP) and server messages, sent reliable
+#define CHANNEL_COUNT 2
+
+#define LINK_PING_INTERVAL 100 // ms between round trip samples while a client streams motion
+#define LINK_LOG_INTERVAL 5000 // ms between link quality log lines
+
 using websocketpp::lib::bind;
 using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
 
-// Enumeration to represent the different macros at their macroCode
-enum Macro
-{
-    ESTOP,
-    CANCEL_MACRO,
-    FULL_EXTEND,
-    FULL_RETRACT,
-    CARRY_POS,
-    DUMP_CYCLE,
-    DUMP_WITH_MOVEMENT,
-    DIG_CYCLE,
-    TURN_RIGHT_45,
-    TURN_LEFT_45,
-    TURN
-};
-
 // Struct containing general packet date for all types
+// Only views the received bytes, they belong to the transport and are valid until the callback returns
 struct PacketData
 {
-    std::string rawMessage;
-    std::vector<std::bitset<8>> rawBinary;
+    const uint8_t *bytes = nullptr; // Raw bytes of the packet
+    std::size_t length = 0;         // Number of raw bytes
+
+    // Copies the packet into a string (allocates, so only call it when the string is needed)
+    std::string rawMessage() const
+    {
+        return std::string((const char *)bytes, length);
+    }
+
+    // Splits the packet into a list of bytes (allocates, so only call it when the bits are needed)
+    std::vector<std::bitset<8>> rawBinary() const
+    {
+        std::vector<std::bitset<8>> binary;
+        binary.reserve(length);
+        // Add bytes to the binary vector one by one
+        for (std::size_t i = 0; i < length; i++)
+        {
+            binary.push_back(std::bitset<8>(bytes[i]));
+        }
+        return binary;
+    }
 };
 
 // Struct with all organized data from motion packets
-struct MotionPacketData : PacketData
+struct MotionPacketData : PacketData, MotionCommand
 {
-    int leftDrivePercent;
-    int rightDrivePercent;
-    ActuatorMotion actuator1;
-    ActuatorMotion actuator2;
 };
 
 // Struct with all organized data from macro packets
-struct MacroPacketData : PacketData
+struct MacroPacketData : PacketData, MacroCommand
 {
-    Macro macro;
-    bool pressed;
-    unsigned int data;
 };
 
 class ServerHandler
@@ -69,26 +86,76 @@ protected:
     // Custom function type to be called when the websocket disconnects or interupts
     typedef std::function<void(ServerHandler *)> DisconnectCallback;
 
-    PacketCallback onPacket;                 // Function to call when any packet is received
-    MotionUpdateCallback onMotionUpdate;     // Function to call when a motion packet is received
-    MacroCallback onMacro;                   // Function to call when a macro packet is received
-    DisconnectCallback onDisconnectCallback; // Function to call when the connection is disconnected or interupted
-
-    // Returns what ActuatorMotion enum item is the case based on the a and b booleans
-    // a | b | motion
-    // --|---|-------
-    // 0 | 0 | NONE
-    // 0 | 1 | RETRACTING
-    // 1 | 0 | EXTENDING
-    // 1 | 1 | NONE
-    static ActuatorMotion getActuatorMotion(bool a, bool b)
-    {
-        if (a == b)
-            return ActuatorMotion::NONE;
-        else if (!a && b)
-            return ActuatorMotion::RETRACTING;
-        else
-            return ActuatorMotion::EXTENDING;
+    // Non-allocating handler types, packets are passed by reference instead of copied
+    typedef InplaceFunction<void(const PacketData &, ServerHandler *)> PacketHandler;
+    typedef InplaceFunction<void(const MotionPacketData &, ServerHandler *)> MotionUpdateHandler;
+    typedef InplaceFunction<void(const MacroPacketData &, ServerHandler *)> MacroHandler;
+    typedef InplaceFunction<void(ServerHandler *)> DisconnectHandler;
+
+    PacketHandler onPacket;                 // Function to call when any packet is received
+    MotionUpdateHandler onMotionUpdate;     // Function to call when a motion packet is received
+    MacroHandler onMacro;                   // Function to call when a macro packet is received
+    DisconnectHandler onDisconnectCallback; // Function to call when the connection is disconnected or interupted
+
+    // Newest motion packet that has not been handed to onMotionUpdate yet
+    // Transports call flushMotion once they have drained everything already received, so a backlog of
+    // motion packets costs one onMotionUpdate call instead of one per packet
+    Mailbox<MotionPacketData> pendingMotion;
+    uint8_t pendingMotionBytes[MAX_MOTION_PACKET_LENGTH]; // Copy of the pending packet's bytes, the transport frees the original
+
+    // Decodes a received packet and runs the matching callbacks, shared by every transport
+    void handlePacket(const uint8_t *bytes, std::size_t length)
+    {
+        // Run packet callback always
+        if (onPacket != nullptr)
+        {
+            PacketData data;
+            data.bytes = bytes;
+            data.length = length;
+            onPacket(data, this);
+        }
+
+        MotionPacketData motion;
+        MacroPacketData macro;
+        PacketType type = decodePacket(bytes, length, motion, macro);
+        TRACE_MARK(DECODE);
+        switch (type)
+        {
+        case PacketType::MOTION:
+            if (onMotionUpdate != nullptr)
+            {
+                std::memcpy(pendingMotionBytes, bytes, length);
+                motion.bytes = pendingMotionBytes;
+                motion.length = length;
+                pendingMotion.post(motion);
+            }
+            break;
+
+        case PacketType::MACRO:
+            // Macros are never coalesced, apply the motion that came before it first to keep the order
+            flushMotion();
+            if (onMacro != nullptr)
+            {
+                macro.bytes = bytes;
+                macro.length = length;
+                onMacro(macro, this);
+            }
+            break;
+
+        case PacketType::INVALID:
+            break;
+        }
+    }
+
+    // Hands the newest pending motion packet (if any) to onMotionUpdate
+    void flushMotion()
+    {
+        MotionPacketData motion;
+        if (pendingMotion.take(motion) && onMotionUpdate != nullptr)
+        {
+            TRACE_MARK(CALLBACK);
+            onMotionUpdate(motion, this);
+        }
     }
 
 public:
@@ -96,30 +163,60 @@ public:
     virtual void run() = 0;
 
     // Send a raw string to the client
-    virtual void sendString(std::string message) = 0;
+    virtual void sendString(const std::string &message) = 0;
 
     // Update the function to call whenever any packet is received
-    void setPacketCallback(PacketCallback onPacket)
+    void setPacketHandler(PacketHandler onPacket)
     {
-        this->onPacket = onPacket;
+        this->onPacket = std::move(onPacket);
     }
 
     // Update the function to call whenever a motion packet is received
-    void setMotionUpdateCallback(MotionUpdateCallback onMotionUpdate)
+    void setMotionUpdateHandler(MotionUpdateHandler onMotionUpdate)
     {
-        this->onMotionUpdate = onMotionUpdate;
+        this->onMotionUpdate = std::move(onMotionUpdate);
     }
 
     // Update the function to call whenever a macro packet is received
-    void setMacroCallback(MacroCallback onMacro)
+    void setMacroHandler(MacroHandler onMacro)
     {
-        this->onMacro = onMacro;
+        this->onMacro = std::move(onMacro);
     }
 
     // Update the function to call when the connection is disconnected or interupted
+    void setDisconnectHandler(DisconnectHandler onDisconnectCallback)
+    {
+        this->onDisconnectCallback = std::move(onDisconnectCallback);
+    }
+
+    // Number of motion packets that were replaced by a newer one before reaching onMotionUpdate
+    unsigned long getSkippedMotionUpdates() const
+    {
+        return pendingMotion.getSkipped();
+    }
+
+    // Same as setPacketHandler but with a by-value std::function (copies the packet for every call)
+    void setPacketCallback(PacketCallback onPacket)
+    {
+        setPacketHandler(std::move(onPacket));
+    }
+
+    // Same as setMotionUpdateHandler but with a by-value std::function (copies the packet for every call)
+    void setMotionUpdateCallback(MotionUpdateCallback onMotionUpdate)
+    {
+        setMotionUpdateHandler(std::move(onMotionUpdate));
+    }
+
+    // Same as setMacroHandler but with a by-value std::function (copies the packet for every call)
+    void setMacroCallback(MacroCallback onMacro)
+    {
+        setMacroHandler(std::move(onMacro));
+    }
+
+    // Same as setDisconnectHandler but with a std::function
     void setDisconnectCallback(DisconnectCallback onDisconnectCallback)
     {
-        this->onDisconnectCallback = onDisconnectCallback;
+        setDisconnectHandler(std::move(onDisconnectCallback));
     }
 };
 
@@ -142,6 +239,9 @@ private:
     // Port
     unsigned int port;
 
+    // True while onMessagesDrained is posted to the io_service
+    bool flushScheduled = false;
+
     static void onConnection(TCPServerHandler *serverHandler, ConnectionHandle hdl)
     {
         serverHandler->connectionHdls.push_back(hdl);
@@ -150,77 +250,16 @@ private:
     // Internal message handler to call in the Websocket++ server object
     static void onMessage(TCPServerHandler *serverHandler, ConnectionHandle hdl, MessagePtr msg)
     {
-        std::string str = msg->get_raw_payload(); // Get packet as a string
-        const char *bytes = str.c_str();          // Convert that string into a dynamic char array
-        std::vector<std::bitset<8>> binary;
-        // Add bytes to the binary vector one by one
-        for (std::size_t i = 0; i < str.size(); i++)
-        {
-            binary.push_back(std::bitset<8>(bytes[i]));
-        }
+        TRACE_BEGIN();
+        TRACE_MARK(RECEIVE);
+        const std::string &str = msg->get_raw_payload(); // Get packet as a string
+        serverHandler->handlePacket((const uint8_t *)str.data(), str.size());
 
-        // Run packet callback always
-        if (serverHandler->onPacket != nullptr)
+        // Apply the newest motion packet once asio has run every message that is already waiting
+        if (serverHandler->pendingMotion.hasValue() && !serverHandler->flushScheduled)
         {
-            PacketData data;
-            data.rawMessage = str;
-            data.rawBinary = binary;
-            serverHandler->onPacket(data, serverHandler);
-        }
-
-        if (str.size() == 2 && !(bytes[0] & 0b10000000))
-        {
-            // Decode packet as a motion packet (manual control of motors & actuators) if length is 2 bytes and first bit is 0
-            bool triggers[4]; // [left bumper, right bumper, left trigger, right trigger]
-            int leftWheelPercent, rightWheelPercent;
-            unsigned char temp = 0b01000000;
-            for (int i = 0; i < 4; i++)
-            {
-                triggers[i] = bytes[0] & temp;
-                temp >>= 1;
-            }
-
-            unsigned int leftMagnitude = (bytes[1] & 0b01110000) >> 4;
-            unsigned int rightMagnitude = bytes[1] & 0b00000111;
-            bool isLeftNegative = bytes[1] & 0b10000000;
-            bool isRightNegative = bytes[1] & 0b00001000;
-
-            leftWheelPercent = isLeftNegative ? -leftMagnitude : leftMagnitude;
-            rightWheelPercent = isRightNegative ? -rightMagnitude : rightMagnitude;
-
-            leftWheelPercent *= 14.28;
-            rightWheelPercent *= 14.28;
-
-            MotionPacketData data;
-            data.rawMessage = str;
-            data.rawBinary = binary;
-            data.leftDrivePercent = leftWheelPercent;
-            data.rightDrivePercent = rightWheelPercent;
-            data.actuator1 = getActuatorMotion(triggers[2], triggers[0]);
-            data.actuator2 = getActuatorMotion(triggers[3], triggers[1]);
-
-            if (serverHandler->onMotionUpdate != nullptr)
-            {
-                serverHandler->onMotionUpdate(data, serverHandler);
-            }
-        }
-        else if ((str.size() == 1 || str.size() == 2) && bytes[0] & 0b10000000)
-        {
-            // Decode packet as a macro packet (preprogrammed action to happen once) if packet length is 1 byte and first bit is 1
-            unsigned int macroCode = (bytes[0] & 0b01111100) >> 2; // 0 < macroCode < 23; code representing macro to execute
-            bool pressed = bytes[0] & 0b00000010;                  // Boolean representing if the button was pressed down
-
-            MacroPacketData data;
-            data.rawMessage = str;
-            data.rawBinary = binary;
-            data.macro = Macro(macroCode);
-            data.pressed = pressed;
-            data.data = str.size() == 2 ? bytes[1] : 0;
-
-            if (serverHandler->onMacro != nullptr)
-            {
-                serverHandler->onMacro(data, serverHandler);
-            }
+            serverHandler->flushScheduled = true;
+            serverHandler->server.get_io_service().post(bind(&onMessagesDrained, serverHandler));
         }
 
         // Commented out example code for sending packets in the future
@@ -235,9 +274,17 @@ private:
         // }
     }
 
+    // Internal method posted behind the queued messages to apply the newest motion packet
+    static void onMessagesDrained(TCPServerHandler *serverHandler)
+    {
+        serverHandler->flushScheduled = false;
+        serverHandler->flushMotion();
+    }
+
     // Internal method to call on disconnect with the Websocket++ server object
     static void onDisconnect(TCPServerHandler *serverHandler)
     {
+        serverHandler->pendingMotion.clear();
         if (serverHandler->onDisconnectCallback != nullptr)
         {
             serverHandler->onDisconnectCallback(serverHandler);
@@ -305,7 +352,7 @@ public:
         }
     }
 
-    void sendString(std::string message)
+    void sendString(const std::string &message)
     {
         for (ConnectionHandle hdl : connectionHdls)
         {
@@ -317,6 +364,17 @@ public:
     }
 };
 
+// Round trip statistics ENet keeps for one client, measured on reliable commands acknowledged after their first send
+struct LinkQuality
+{
+    uint32_t roundTripMicros;         // Smoothed round trip time
+    uint32_t roundTripVarianceMicros; // Mean deviation from roundTripMicros
+    uint32_t jitterMicros;            // Smoothed difference between consecutive round trips
+    uint32_t lastRoundTripMicros;
+    uint32_t samples; // 0 until the first acknowledgement, the other fields mean nothing before that
+    float packetLoss; // Fraction of reliable packets resent, 0 to 1
+};
+
 // UDP server class to use with our motor controller stuff
 class UDPServerHandler : public ServerHandler
 {
@@ -324,13 +382,249 @@ class UDPServerHandler : public ServerHandler
 private:
     ENetHost *server;
     ENetAddress address;
+    int serviceTimer = -1; // Wakes the reactor when ENet has a resend, ping or acknowledgement due
+
+    ENetPeer *motionPeer = nullptr; // Client that last sent motion, the one driving the robot
+    Seqlock<LinkQuality> motionLink; // Its link quality, copied out after every service for other threads
+    enet_uint32 lastLinkPing = 0;
+    enet_uint32 lastLinkLog = 0;
+
+    // What the server remembers about each connected client, indexed like server->peers
+    struct PeerState
+    {
+        bool hasMotionSequence; // False until the peer sends its first sequenced motion packet
+        uint16_t lastMotionSequence;
+    };
+    std::vector<PeerState> peerStates;
+    std::atomic<unsigned long> staleMotionPackets{0}; // Read by other threads for display
+
+    // Fast motion datagrams (see fastmotion.hpp), only accepted once enableFastMotion sets the key
+    uint8_t fastMotionKey[FastMotion::KEY_LENGTH];
+    std::atomic<unsigned long> fastMotionPackets{0};  // Read by other threads for display
+    std::atomic<unsigned long> rejectedFastMotion{0}; // Signed correctly but not from a connected peer
+
+    std::atomic<unsigned long> checksumFailures{0}; // Copy of server->totalChecksumFailures for other threads
+
+    // Packets sent from a callback wait for the end of service() so they can share a datagram
+    bool inService = false;
+    bool flushPending = false;
+
+    // Handler servicing its host on the calling thread
+    // ENetHost has no user data pointer, so this is how the intercept callback finds the handler
+    static UDPServerHandler *&servicing()
+    {
+        thread_local UDPServerHandler *handler = nullptr;
+        return handler;
+    }
+
+    // Runs on every datagram ENet receives before it parses it, returns 1 if it was handled here
+    static int ENET_CALLBACK interceptDatagram(ENetHost *host, ENetEvent *)
+    {
+        UDPServerHandler *handler = servicing();
+        if (handler == nullptr || handler->server != host || !isFastMotion(host->receivedData, host->receivedDataLength))
+            return 0;
+        return handler->handleFastMotion() ? 1 : 0;
+    }
+
+    // Decodes the fast motion datagram in the receive buffer, returns false to let ENet handle it instead
+    bool handleFastMotion()
+    {
+        uint8_t packet[MAX_MOTION_PACKET_LENGTH];
+        if (!decodeFastMotion(server->receivedData, fastMotionKey, packet))
+            return false;
+
+        ENetPeer *peer = findConnectedPeer(server->receivedAddress);
+        if (peer == nullptr)
+        {
+            rejectedFastMotion.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        TRACE_MARK(RECEIVE);
+        fastMotionPackets.fetch_add(1, std::memory_order_relaxed);
+        motionPeer = peer;
+        if (isStaleMotion(peer, packet, sizeof(packet)))
+            staleMotionPackets.fetch_add(1, std::memory_order_relaxed);
+        else
+            handlePacket(packet, sizeof(packet));
+        return true;
+    }
+
+    ENetPeer *findConnectedPeer(const ENetAddress &address)
+    {
+        ENetPeer *peer = enet_host_find_peer(server, &address);
+        return peer != NULL && peer->state == ENET_PEER_STATE_CONNECTED ? peer : nullptr;
+    }
+
+    // Returns true if a motion packet is older than one already received from <peer>
+    // Unsequenced motion can arrive out of order, an older packet would undo the newer command
+    bool isStaleMotion(ENetPeer *peer, const enet_uint8 *bytes, size_t length)
+    {
+        uint16_t sequence;
+        if (!getMotionSequence(bytes, length, sequence))
+            return false;
+
+        PeerState &state = peerStates[peer - server->peers];
+        if (state.hasMotionSequence && !isNewerSequence(sequence, state.lastMotionSequence))
+            return true;
+
+        state.hasMotionSequence = true;
+        state.lastMotionSequence = sequence;
+        return false;
+    }
+
+    static LinkQuality getLinkQuality(const ENetPeer *peer)
+    {
+        return LinkQuality{peer->roundTripTimeMicros, peer->roundTripTimeVarianceMicros, peer->roundTripJitterMicros,
+                           peer->lastRoundTripTimeMicros, peer->roundTripSamples,
+                           (float)peer->packetLoss / ENET_PEER_PACKET_LOSS_SCALE};
+    }
+
+    // Publishes the driving client's link quality and logs every client's every LINK_LOG_INTERVAL ms
+    void updateLinkQuality()
+    {
+        const enet_uint32 now = enet_time_get();
+        if (motionPeer != nullptr)
+        {
+            motionLink.store(getLinkQuality(motionPeer));
+
+            // ENet only pings idle peers and unsequenced motion is never acknowledged, so without this a client
+            // streaming motion gets no round trip samples at all
+            if (ENET_TIME_DIFFERENCE(now, lastLinkPing) >= LINK_PING_INTERVAL && enet_list_empty(&motionPeer->sentReliableCommands))
+            {
+                enet_peer_ping(motionPeer);
+                lastLinkPing = now;
+            }
+        }
+
+        if (ENET_TIME_DIFFERENCE(now, lastLinkLog) < LINK_LOG_INTERVAL)
+            return;
+        lastLinkLog = now;
+
+        for (ENetListIterator node = enet_list_begin(&server->activePeers); node != enet_list_end(&server->activePeers); node = enet_list_next(node))
+        {
+            ENetPeer *peer = ENET_ACTIVE_PEER(node);
+            if (peer->state != ENET_PEER_STATE_CONNECTED || peer->roundTripSamples == 0)
+                continue;
+            LinkQuality link = getLinkQuality(peer);
+            packetLog().log("Link to %u:%u: rtt %u us (+/- %u), jitter %u us, loss %.1f%%.", peer->address.host, peer->address.port,
+                            link.roundTripMicros, link.roundTripVarianceMicros, link.jitterMicros, link.packetLoss * 100);
+        }
+    }
+
+    // Milliseconds until ENet next has work to do without any packet arriving, 0 if it has some now
+    // Mirrors the timers enet_protocol_send_outgoing_commands checks, capped at the bandwidth throttle interval
+    enet_uint32 nextServiceDelay()
+    {
+        const enet_uint32 now = enet_time_get();
+        enet_uint32 delay = ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL;
+
+        auto until = [now, &delay](enet_uint32 time)
+        {
+            enet_uint32 remaining = ENET_TIME_LESS(now, time) ? ENET_TIME_DIFFERENCE(time, now) : 0;
+            if (remaining < delay)
+                delay = remaining;
+        };
+
+        // Datagrams left from a batched receive are already off the socket, so it won't wake the reactor for them
+        if (server->receiveBatchIndex < server->receiveBatchCount)
+            return 0;
+
+        until(server->bandwidthThrottleEpoch + ENET_HOST_BANDWIDTH_THROTTLE_INTERVAL);
+        for (ENetListIterator node = enet_list_begin(&server->activePeers); node != enet_list_end(&server->activePeers); node = enet_list_next(node))
+        {
+            ENetPeer *peer = ENET_ACTIVE_PEER(node);
+            if (peer->state == ENET_PEER_STATE_ZOMBIE)
+                continue;
+
+            // Queued acknowledgements go out on the next service, and so do queued commands unless reliable ones are in flight:
+            // then they are waiting for the reliable window, which only opens when an acknowledgement arrives (the socket
+            // wakes us) or at nextTimeout below
+            if (!enet_list_empty(&peer->acknowledgements))
+                return 0;
+            if ((!enet_list_empty(&peer->outgoingCommands) || !enet_list_empty(&peer->outgoingSendReliableCommands)) &&
+                enet_list_empty(&peer->sentReliableCommands))
+                return 0;
+
+            // Reliable commands in flight are resent (or time the peer out) at nextTimeout, idle peers get pinged
+            if (!enet_list_empty(&peer->sentReliableCommands))
+                until(peer->nextTimeout);
+            else
+                until(peer->lastReceiveTime + peer->pingInterval);
+        }
+
+        return delay;
+    }
+
+    // Handles one ENet event
+    void handleEvent(ENetEvent &event)
+    {
+        ENetPacket *packet = event.packet;
+        const size_t length = packet != NULL ? packet->dataLength : 0;
+        const enet_uint8 *bytes = packet != NULL ? packet->data : nullptr;
+
+        switch (event.type)
+        {
+        case ENET_EVENT_TYPE_CONNECT:
+            packetLog().log("A new client connected from %u:%u.", event.peer->address.host, event.peer->address.port);
+
+            /* Store any relevant client information here. */
+            // event.peer->data = "Client information";
+            peerStates[event.peer - server->peers] = PeerState{};
+
+            break;
+
+        case ENET_EVENT_TYPE_RECEIVE:
+            if (packet == NULL)
+                break;
+            TRACE_MARK(RECEIVE);
+            packetLog().log("A packet of length %zu was received from %u:%u on channel %u.", length, event.peer->address.host, event.peer->address.port, event.channelID);
+
+            if (isMotionPacket(bytes, length))
+                motionPeer = event.peer;
+            if (isMotionPacket(bytes, length) && isStaleMotion(event.peer, bytes, length))
+                staleMotionPackets.fetch_add(1, std::memory_order_relaxed);
+            else
+                handlePacket(bytes, length);
+
+            /* Clean up the packet now that we're done using it. */
+            enet_packet_destroy(event.packet);
+
+            break;
+
+        case ENET_EVENT_TYPE_DISCONNECT:
+            packetLog().log("%u:%u disconnected.", event.peer->address.host, event.peer->address.port);
+
+            /* Reset the peer's client information. */
+
+            event.peer->data = NULL;
+
+            // Only the client driving the robot stops it, other clients come and go without touching its motion
+            if (event.peer == motionPeer)
+            {
+                motionPeer = nullptr;
+                motionLink.store(LinkQuality{});
+
+                // Don't apply motion that was queued behind the disconnect
+                pendingMotion.clear();
+                if (onDisconnectCallback != nullptr)
+                {
+                    onDisconnectCallback(this);
+                }
+            }
+            break;
+
+        case ENET_EVENT_TYPE_NONE:
+            break;
+        }
+    }
 
 public:
     // Constructor to automatically setup the server
     UDPServerHandler()
     {
-        // initializes ENet Library
-        if (enet_initialize() != 0)
+        // initializes ENet Library, packets and protocol commands come from slab pools instead of malloc
+        if (EnetPool::initialize() != 0)
         {
             std::cout << "An error occurred while initializing ENet.\n";
             return;
@@ -349,7 +643,7 @@ public:
         server = enet_host_create(
             &address /* the address to bind the server host to */,
             32 /* allow up to 32 clients and/or outgoing connections */,
-            2 /* allow up to 2 channels to be used, 0 and 1 */,
+            CHANNEL_COUNT /* allow up to 2 channels to be used, MOTION_CHANNEL and CONTROL_CHANNEL */,
             0 /* assume any amount of incoming bandwidth */,
             0 /* assume any amount of outgoing bandwidth */
         );
@@ -359,6 +653,7 @@ public:
             std::cout << "An error occurred while trying to create an ENet server host.\n";
             exit(EXIT_FAILURE);
         }
+        peerStates.resize(server->peerCount);
     }
 
     // Destructor
@@ -367,122 +662,166 @@ public:
         enet_host_destroy(server);
     }
 
-    // Runs loop to listen for incoming connections, incoming messages, and disconnections/interuptions
-    void run()
+    // Lets <reactor> drive the server: ENet is serviced when its socket is readable or one of its timers is due,
+    // so nothing polls while the link is idle
+    void attach(Reactor &reactor)
+    {
+        reactor.watch(server->socket, EPOLLIN, [this](int, uint32_t)
+                      {
+                          TRACE_BEGIN(); // Datagrams are traced from the moment the socket woke us up
+                          service(); });
+        serviceTimer = reactor.addTimer([this](int, uint32_t)
+                                        {
+                                            TRACE_END();
+                                            service(); });
+        service();
+    }
+
+    // Handles everything ENet has ready without blocking, then arms the timer for ENet's next deadline
+    void service()
     {
         ENetEvent event;
+        int result;
+        bool progress = false; // Whether this call received, sent or handled anything
+        const enet_uint32 sentBefore = server->totalSentPackets;
+        const enet_uint32 receivedBefore = server->totalReceivedPackets;
+
+        servicing() = this;
+        inService = true;
+        while ((result = enet_host_service(server, &event, 0)) > 0)
+        {
+            // Handle every event that already arrived before applying motion, so a burst only applies the newest command
+            do
+            {
+                handleEvent(event);
+            } while (enet_host_check_events(server, &event) > 0);
+            progress = true;
+        }
+        if (result < 0)
+            packetLog().log("An error occurred while servicing the ENet host.");
 
-        while (enet_host_service(server, &event, 100) >= 0)
+        flushMotion();
+        inService = false;
+        if (flushPending)
         {
-            ENetPacket *packet = event.packet;
-            const size_t length = packet != NULL ? packet->dataLength : NULL;
-            const enet_uint8 *bytes = packet != NULL ? packet->data : nullptr;
-            std::vector<std::bitset<8>> binary;
+            enet_host_flush(server);
+            flushPending = false;
+        }
+        updateLinkQuality();
+        checksumFailures.store(server->totalChecksumFailures, std::memory_order_relaxed);
 
-            switch (event.type)
-            {
-            case ENET_EVENT_TYPE_CONNECT:
-                std::cout << "A new client connected from " << event.peer->address.host << ":" << event.peer->address.port << ".\n";
+        progress = progress || server->totalSentPackets != sentBefore || server->totalReceivedPackets != receivedBefore;
 
-                /* Store any relevant client information here. */
-                // event.peer->data = "Client information";
+        // Work that is due now fires the timer right away (a zero delay would disarm it), unless this call couldn't
+        // make any progress on it: then ENet is waiting on something (bandwidth, window), retry on its next tick
+        enet_uint32 delay = nextServiceDelay();
+        if (serviceTimer >= 0)
+            Reactor::armTimer(serviceTimer, delay > 0 ? (int64_t)delay * 1000000 : progress ? 1 : 1000000);
+    }
 
-                break;
+    // Runs loop to listen for incoming connections, incoming messages, and disconnections/interuptions
+    void run()
+    {
+        Reactor reactor;
+        attach(reactor);
+        reactor.run();
+    }
 
-            case ENET_EVENT_TYPE_RECEIVE:
-                if (packet == NULL)
-                    continue;
-                std::cout << "A packet of length " << length << " containing " << bytes << " was received from " << event.peer->data << " on channel " << event.channelID << ".\n";
+    // Adds a CRC32 to every datagram and drops received ones whose CRC doesn't match
+    // Every client has to set the same checksum on its host, datagrams without one fail the check
+    void enableChecksum()
+    {
+        server->checksum = enet_crc32;
+        packetLog().log("ENet checksums enabled (%s).", enet_crc32_implementation());
+    }
 
-                // Add bytes to the binary vector one by one
-                for (std::size_t i = 0; i < length; i++)
-                {
-                    binary.push_back(std::bitset<8>(bytes[i]));
-                }
+    // Compresses datagrams with the ENet compressor named <compressor>, "lz" (cheap, meant for telemetry) or "range"
+    // (ENet's range coder, smaller but an order of magnitude slower), every client has to use the same one
+    // Returns false for an unknown name or if it couldn't be created
+    bool enableCompression(const std::string &compressor)
+    {
+        int result;
+        if (compressor == "lz")
+            result = enet_host_compress_with_lz(server);
+        else if (compressor == "range")
+            result = enet_host_compress_with_range_coder(server);
+        else
+            return false;
 
-                // Run packet callback always
-                if (onPacket != nullptr)
-                {
-                    PacketData data;
-                    data.rawMessage = std::string((char *)bytes, length);
-                    data.rawBinary = binary;
-                    onPacket(data, this);
-                }
+        if (result != 0)
+            return false;
+        packetLog().log("ENet compression enabled (%s).", compressor.c_str());
+        return true;
+    }
 
-                if (length == 2 && !(bytes[0] & 0b10000000))
-                {
-                    // Decode packet as a motion packet (manual control of motors & actuators) if length is 2 bytes and first bit is 0
-                    bool triggers[4]; // [left bumper, right bumper, left trigger, right trigger]
-                    int leftWheelPercent, rightWheelPercent;
-                    unsigned char temp = 0b01000000;
-                    for (int i = 0; i < 4; i++)
-                    {
-                        triggers[i] = bytes[0] & temp;
-                        temp >>= 1;
-                    }
-
-                    unsigned int leftMagnitude = (bytes[1] & 0b01110000) >> 4;
-                    unsigned int rightMagnitude = bytes[1] & 0b00000111;
-                    bool isLeftNegative = bytes[1] & 0b10000000;
-                    bool isRightNegative = bytes[1] & 0b00001000;
-
-                    leftWheelPercent = isLeftNegative ? -leftMagnitude : leftMagnitude;
-                    rightWheelPercent = isRightNegative ? -rightMagnitude : rightMagnitude;
-
-                    leftWheelPercent *= 14.28;
-                    rightWheelPercent *= 14.28;
-
-                    MotionPacketData data;
-                    data.rawMessage = std::string((char *)bytes, length);
-                    data.rawBinary = binary;
-                    data.leftDrivePercent = leftWheelPercent;
-                    data.rightDrivePercent = rightWheelPercent;
-                    data.actuator1 = getActuatorMotion(triggers[2], triggers[0]);
-                    data.actuator2 = getActuatorMotion(triggers[3], triggers[1]);
-
-                    if (onMotionUpdate != nullptr)
-                    {
-                        onMotionUpdate(data, this);
-                    }
-                }
-                else if ((length == 1 || length == 2) && bytes[0] & 0b10000000)
-                {
-                    // Decode packet as a macro packet (preprogrammed action to happen once) if packet length is 1 byte and first bit is 1
-                    unsigned int macroCode = (bytes[0] & 0b01111100) >> 2; // 0 < macroCode < 23; code representing macro to execute
-                    bool pressed = bytes[0] & 0b00000010;                  // Boolean representing if the button was pressed down
-
-                    MacroPacketData data;
-                    data.rawMessage = std::string((char *)bytes, length);
-                    data.rawBinary = binary;
-                    data.macro = Macro(macroCode);
-                    data.pressed = pressed;
-                    data.data = length == 2 ? bytes[1] : 0;
-
-                    if (onMacro != nullptr)
-                    {
-                        onMacro(data, this);
-                    }
-                }
+    // Accepts fast motion datagrams signed with the 16 byte <key> alongside normal ENet packets
+    void enableFastMotion(const uint8_t *key)
+    {
+        std::memcpy(fastMotionKey, key, FastMotion::KEY_LENGTH);
+        server->intercept = interceptDatagram;
+    }
 
-                /* Clean up the packet now that we're done using it. */
-                enet_packet_destroy(event.packet);
+    // Number of fast motion datagrams accepted
+    unsigned long getFastMotionPackets()
+    {
+        return fastMotionPackets.load(std::memory_order_relaxed);
+    }
 
-                break;
+    // Number of correctly signed fast motion datagrams dropped because the sender wasn't connected
+    unsigned long getRejectedFastMotion()
+    {
+        return rejectedFastMotion.load(std::memory_order_relaxed);
+    }
+
+    // Number of datagrams dropped because their checksum didn't match, 0 unless enableChecksum was called
+    unsigned long getChecksumFailures()
+    {
+        return checksumFailures.load(std::memory_order_relaxed);
+    }
 
-            case ENET_EVENT_TYPE_DISCONNECT:
-                std::cout << event.peer->data << " disconnected.\n";
+    // Number of motion packets dropped because a newer one from the same client had already arrived
+    unsigned long getStaleMotionPackets()
+    {
+        return staleMotionPackets.load(std::memory_order_relaxed);
+    }
 
-                /* Reset the peer's client information. */
+    // Link quality to the client currently sending motion, all zero while none is (safe from any thread)
+    LinkQuality getMotionLinkQuality() const
+    {
+        return motionLink.load();
+    }
 
-                event.peer->data = NULL;
-            }
-        }
+    // Copies <message> into a packet, small ones come from the ENet payload pool so this doesn't malloc
+    void sendString(const std::string &message)
+    {
+        ENetPacket *packet = enet_packet_create(message.data(), message.size(), ENET_PACKET_FLAG_RELIABLE);
+        if (packet != NULL)
+            broadcast(packet);
+    }
+
+    // Sends <length> bytes at <data> to every client without copying them
+    // The buffer must not change until ENet calls <release> with the packet (its userData is <userData>), once every
+    // client has acknowledged it or right away if none is connected
+    // Returns false if the packet couldn't be created, <release> is not called and the buffer is the caller's again
+    bool sendBuffer(const void *data, size_t length, ENetPacketFreeCallback release, void *userData)
+    {
+        ENetPacket *packet = enet_packet_create(data, length, ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_NO_ALLOCATE);
+        if (packet == NULL)
+            return false;
+        packet->freeCallback = release;
+        packet->userData = userData;
+        broadcast(packet);
+        return true;
     }
 
-    void sendString(std::string message)
+private:
+    // Queues <packet> for every client, sent at the end of service() when called from a callback and right away otherwise
+    void broadcast(ENetPacket *packet)
     {
-        ENetPacket *packet = enet_packet_create(message.c_str(), message.size(), ENET_PACKET_FLAG_RELIABLE);
-        enet_host_broadcast(server, 0, packet);
-        enet_host_flush(server);
+        enet_host_broadcast(server, CONTROL_CHANNEL, packet);
+        if (inService)
+            flushPending = true;
+        else
+            enet_host_flush(server);
     }
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// SipHash-2-4 keyed hash (https://131002.net/siphash/), a short message authentication code that is cheap enough
+// to check on every packet
+// <key> is 16 bytes, the result is the 64 bit tag
+inline uint64_t siphash24(const uint8_t *key, const uint8_t *data, std::size_t length)
+{
+    auto read64 = [](const uint8_t *bytes)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--)
+            value = value << 8 | bytes[i];
+        return value;
+    };
+    auto rotl = [](uint64_t value, int bits)
+    { return (value << bits) | (value >> (64 - bits)); };
+
+    const uint64_t k0 = read64(key);
+    const uint64_t k1 = read64(key + 8);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    auto round = [&]()
+    {
+        v0 += v1;
+        v1 = rotl(v1, 13);
+        v1 ^= v0;
+        v0 = rotl(v0, 32);
+        v2 += v3;
+        v3 = rotl(v3, 16);
+        v3 ^= v2;
+        v0 += v3;
+        v3 = rotl(v3, 21);
+        v3 ^= v0;
+        v2 += v1;
+        v1 = rotl(v1, 17);
+        v1 ^= v2;
+        v2 = rotl(v2, 32);
+    };
+
+    const std::size_t blocks = length / 8;
+    for (std::size_t i = 0; i < blocks; i++)
+    {
+        uint64_t m = read64(data + i * 8);
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    }
+
+    // Last block holds the remaining bytes and the message length in its top byte
+    uint64_t last = (uint64_t)length << 56;
+    const uint8_t *tail = data + blocks * 8;
+    for (std::size_t i = 0; i < length % 8; i++)
+        last |= (uint64_t)tail[i] << (8 * i);
+
+    v3 ^= last;
+    round();
+    round();
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    round();
+    round();
+    round();
+    round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
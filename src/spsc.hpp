@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer/single-consumer ring buffer
+// push and pop never block or allocate, they just fail when the ring is full or empty
+// Exactly one thread may push and exactly one (other) thread may pop
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    static const std::size_t MASK = Capacity - 1;
+
+    // Kept on separate cache lines so the producer and consumer don't fight over one line
+    alignas(64) std::atomic<std::size_t> head{0}; // Next slot to pop, only written by the consumer
+    alignas(64) std::atomic<std::size_t> tail{0}; // Next slot to push, only written by the producer
+    alignas(64) T slots[Capacity];
+
+public:
+    // Copy <value> into the ring, returns false if it is full (producer thread only)
+    bool push(const T &value)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        slots[t & MASK] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copy the oldest value into <out>, returns false if the ring is empty (consumer thread only)
+    bool pop(T &out)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        out = slots[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of values waiting, only a snapshot when called from a third thread
+    std::size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity()
+    {
+        return Capacity;
+    }
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+
+// Points on the path of a motion packet from the socket to the pins, in the order it passes them
+enum class TraceStage
+{
+    RECEIVE,   // ENet handed the packet over
+    DECODE,    // Packet decoded into a command
+    CALLBACK,  // Motion update handler entered
+    SET_DRIVE, // MotorController::setDrivePercent entered
+    PWM_WRITE, // Drive motor gpioPWM calls returned
+    GPIO_WRITE // Actuator gpioWrite calls returned
+};
+
+#define TRACE_STAGE_COUNT 6
+
+// Per-stage latency histograms, enabled by compiling with LATENCY_TRACE defined (the LATENCY_TRACE CMake option)
+// A thread starts a trace when a datagram wakes it, every stage it then reaches records the time since that start.
+// The trace start travels with a command to another thread by handing it over and adopting it there.
+// Without LATENCY_TRACE all the TRACE_ macros are empty and nothing is compiled in.
+#ifdef LATENCY_TRACE
+
+// Latency counts in buckets 4 per power of two wide, so percentiles are within 25% of the real value
+class LatencyHistogram
+{
+public:
+    static const int BUCKETS = 256;
+
+private:
+    // Only written by one thread, read by any
+    std::atomic<unsigned long> counts[BUCKETS] = {};
+    std::atomic<unsigned long> total{0};
+    std::atomic<int64_t> max{0};
+
+    static int bucketOf(uint64_t nanos)
+    {
+        if (nanos < 4)
+            return nanos;
+        int msb = 63 - __builtin_clzll(nanos);
+        return 4 * (msb - 1) + ((nanos >> (msb - 2)) & 3);
+    }
+
+    // Largest latency that lands in <bucket>
+    static int64_t upperBound(int bucket)
+    {
+        if (bucket < 4)
+            return bucket;
+        int msb = bucket / 4 + 1;
+        return (((int64_t)(bucket % 4) + 5) << (msb - 2)) - 1;
+    }
+
+public:
+    void record(int64_t nanos)
+    {
+        if (nanos < 0)
+            nanos = 0;
+        std::atomic<unsigned long> &count = counts[bucketOf(nanos)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (nanos > max.load(std::memory_order_relaxed))
+            max.store(nanos, std::memory_order_relaxed);
+    }
+
+    unsigned long getCount() const
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    int64_t getMax() const
+    {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    // Latency in ns that <fraction> (0 to 1) of the recorded samples are at or below
+    int64_t percentile(double fraction) const
+    {
+        unsigned long target = fraction * getCount();
+        unsigned long seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen > target)
+                return std::min(upperBound(i), getMax());
+        }
+        return getMax();
+    }
+};
+
+namespace LatencyTrace
+{
+    // CLOCK_MONOTONIC_RAW time in ns, not slewed by NTP so short intervals stay exact
+    inline int64_t now()
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+        return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+    }
+
+    inline LatencyHistogram *histograms()
+    {
+        static LatencyHistogram stages[TRACE_STAGE_COUNT];
+        return stages;
+    }
+
+    // Start time of the trace the calling thread is working on, 0 if none
+    inline int64_t &origin()
+    {
+        thread_local int64_t start = 0;
+        return start;
+    }
+
+    inline void mark(TraceStage stage)
+    {
+        int64_t start = origin();
+        if (start != 0)
+            histograms()[(int)stage].record(now() - start);
+    }
+
+    inline const char *stageName(TraceStage stage)
+    {
+        static const char *names[TRACE_STAGE_COUNT] = {"receive", "decode", "callback", "setDrivePercent", "gpioPWM", "gpioWrite"};
+        return names[(int)stage];
+    }
+
+    // One line per stage: samples, p50, p99 and max latency since the trace start in us
+    inline void dump(std::ostream &out)
+    {
+        out << std::left << std::setw(18) << "Stage" << std::right << std::setw(10) << "Samples"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "max us" << "\n";
+        for (int i = 0; i < TRACE_STAGE_COUNT; i++)
+        {
+            const LatencyHistogram &histogram = histograms()[i];
+            out << std::left << std::setw(18) << stageName((TraceStage)i) << std::right << std::setw(10) << histogram.getCount()
+                << std::fixed << std::setprecision(1)
+                << std::setw(10) << histogram.percentile(0.50) / 1000.0
+                << std::setw(10) << histogram.percentile(0.99) / 1000.0
+                << std::setw(10) << histogram.getMax() / 1000.0 << "\n";
+        }
+    }
+}
+
+#define TRACE_BEGIN() (LatencyTrace::origin() = LatencyTrace::now())     // Start a trace on this thread now
+#define TRACE_ADOPT(start) (LatencyTrace::origin() = (start))             // Continue a trace handed over from another thread
+#define TRACE_END() (LatencyTrace::origin() = 0)                          // Stop recording on this thread
+#define TRACE_ORIGIN() LatencyTrace::origin()                             // Start of this thread's trace, to hand over
+#define TRACE_MARK(stage) LatencyTrace::mark(TraceStage::stage)           // Record the time since the start for <stage>
+
+#else
+
+#define TRACE_BEGIN() ((void)0)
+#define TRACE_ADOPT(start) ((void)0)
+#define TRACE_END() ((void)0)
+#define TRACE_ORIGIN() ((int64_t)0)
+#define TRACE_MARK(stage) ((void)0)
+
+#endif
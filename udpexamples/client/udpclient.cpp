@@ -2,6 +2,9 @@
 #include <enet/enet.h>
 #include <string.h>
 
+#define MOTION_CHANNEL 0  // Unsequenced motion packets, same policy as src/server.hpp
+#define CONTROL_CHANNEL 1 // Reliable macro packets
+
 ENetHost *client;
 ENetAddress address;
 ENetEvent event;
@@ -30,6 +33,18 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
+    // Must match the server, which checksums its datagrams when started with ENET_CHECKSUM=1
+    const char *checksum = getenv("ENET_CHECKSUM");
+    if (checksum != NULL && strcmp(checksum, "1") == 0)
+        client->checksum = enet_crc32;
+
+    // Must also match the server's ENET_COMPRESS
+    const char *compressor = getenv("ENET_COMPRESS");
+    if (compressor != NULL && strcmp(compressor, "lz") == 0)
+        enet_host_compress_with_lz(client);
+    else if (compressor != NULL && strcmp(compressor, "range") == 0)
+        enet_host_compress_with_range_coder(client);
+
     /* Connect to some.server.net:1234. */
     enet_address_set_host(&address, "localhost");
     address.port = 9002;
@@ -42,18 +57,22 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
+    enet_uint16 sequence = 0;
+
     /* Wait up to 1000 milliseconds for an event. */
     while (enet_host_service(client, &event, 1000) >= 0)
     {
-        /* Create a reliable packet of size 7 containing "packet\0" */
-        ENetPacket *packet = enet_packet_create("Pz",
-                                                2,
-                                                ENET_PACKET_FLAG_RELIABLE);
-
-        /* Send the packet to the peer over channel id 0. */
-        /* One could also broadcast the packet by         */
-        /* enet_host_broadcast (host, 0, packet);         */
-        enet_peer_send(client->peers, 0, packet);
+        /* Create an unsequenced motion packet containing "Pz" followed by a big endian sequence number, */
+        /* the server drops any that arrive after a newer one. Macros would be sent with                  */
+        /* ENET_PACKET_FLAG_RELIABLE over CONTROL_CHANNEL instead.                                        */
+        enet_uint8 motion[4] = {'P', 'z', (enet_uint8)(sequence >> 8), (enet_uint8)(sequence & 0xFF)};
+        sequence++;
+        ENetPacket *packet = enet_packet_create(motion,
+                                                sizeof(motion),
+                                                ENET_PACKET_FLAG_UNSEQUENCED);
+
+        /* Send the packet to the peer over the motion channel. */
+        enet_peer_send(client->peers, MOTION_CHANNEL, packet);
 
         /* One could just use enet_host_service() instead. */
         enet_host_flush(client);